@@ -1,8 +1,33 @@
 //=============================================================================================
-// Zld hromszg: A framework.h osztlyait felhasznl megolds
+// Zöld háromszög: A framework.h osztályait felhasználó megoldás
 //=============================================================================================
 #include "framework.h"
-// cscspont rnyal
+#include "naplo.h"
+#include <thread>
+#include <limits>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <functional>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+//a ritkán futó, hosszú pontos ágak ne kerüljenek be a hívók belső ciklusaiba
+#if defined(_MSC_VER)
+#define NOINLINE __declspec(noinline)
+#elif defined(__GNUC__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+// csúcspont árnyaló
 const char* vertSource = R"(
 	#version 330				
     precision highp float;
@@ -10,17 +35,17 @@ const char* vertSource = R"(
 	layout(location = 0) in vec2 cP;	// 0. bemeneti regiszter
 
 	void main() {
-		gl_Position = vec4(cP.x, cP.y, 0, 1); 	// bemenet mr normalizlt eszkzkoordintkban
+		gl_Position = vec4(cP.x, cP.y, 0, 1); 	// bemenet már normalizált eszközkoordinátákban
 	}
 )";
 
-// pixel rnyal
+// pixel árnyaló
 const char* fragSource = R"(
 	#version 330
     precision highp float;
 
-	uniform vec3 color;			// konstans szn
-	out vec4 fragmentColor;		// pixel szn
+	uniform vec3 color;			// konstans szín
+	out vec4 fragmentColor;		// pixel szín
 
 	void main() {
 		fragmentColor = vec4(color, 1); // RGB -> RGBA
@@ -29,33 +54,133 @@ const char* fragSource = R"(
 
 const int winWidth = 600, winHeight = 600;
 
+//Egyenletes rács a [-1,1] ablak felett, cellánként a pontok indexeivel (felvételi, azaz növekvő sorrendben)
+class Grid {
+	std::vector<std::vector<int>> cells;
+public:
+	static constexpr int N = 64;
+	Grid() : cells(N * N) {}
+	//Koordináta -> oszlop/sor (az ablakon kívüli elemek a szélső cellákba kerülnek)
+	static int Col(float x) { int c = (int)floor((x + 1.0f) * 0.5f * N); return c < 0 ? 0 : (c >= N ? N - 1 : c); }
+	static int Row(float y) { return Col(y); }
+	int Cell(float x, float y) { return Row(y) * N + Col(x); }
+	void Insert(int cell, int id) { cells[cell].push_back(id); }
+	//A legutóbb felvett elem a cellája végén van, ezért hátulról keresünk
+	void Remove(int cell, int id) {
+		std::vector<int>& c = cells[cell];
+		for (size_t i = c.size(); i-- > 0;) {
+			if (c[i] == id) { c.erase(c.begin() + i); return; }
+		}
+	}
+	const std::vector<int>& At(int col, int row) { return cells[row * N + col]; }
+};
+
+//Csúcspuffer feltöltő: a GPU-s és a méréshez használt CPU-s változat ugyanezt a felületet adja
+class BufferUploader {
+public:
+	//A cél csúcspuffer kötése a feltöltés előtt; CPU-s változatnál nincs mit kötni
+	virtual void Bind(Geometry<vec3>* geometry) {}
+	//Új, bytes méretű puffer lefoglalása (tartalom nélkül)
+	virtual void Allocate(size_t bytes) = 0;
+	//A puffer [offset, offset+bytes) tartományának felülírása
+	virtual void Upload(size_t offset, size_t bytes, const void* data) = 0;
+	virtual ~BufferUploader() {}
+};
+class GLUploader : public BufferUploader {
+public:
+	void Bind(Geometry<vec3>* geometry) { geometry->Bind(); }
+	void Allocate(size_t bytes) { glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_DYNAMIC_DRAW); }
+	void Upload(size_t offset, size_t bytes, const void* data) { glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data); }
+};
+//GL nélküli változat: csak számolja a lefoglalt és feltöltött bájtokat
+class CountingUploader : public BufferUploader {
+public:
+	size_t allocated = 0, uploaded = 0, uploads = 0;
+	void Allocate(size_t bytes) { allocated += bytes; }
+	void Upload(size_t offset, size_t bytes, const void* data) { uploaded += bytes; uploads++; }
+};
+GLUploader glUploader;
+
 class Object : public Geometry<vec3> {
+	BufferUploader* uploader = &glUploader;
+	size_t capacity = 0;				 //a GPU pufferben lefoglalt csúcsok száma
+	size_t dirtyBegin = 0, dirtyEnd = 0; //a GPU-ra még fel nem töltött csúcsok tartománya
+protected:
+	void MarkDirty(size_t first, size_t count) {
+		if (dirtyBegin == dirtyEnd) { dirtyBegin = first; dirtyEnd = first + count; return; }
+		dirtyBegin = std::min(dirtyBegin, first);
+		dirtyEnd = std::max(dirtyEnd, first + count);
+	}
 public:
 	Object() : Geometry<vec3>() {}
-	//megvltoztats
-    void AddNew(const vec3& nobject) { vtx.push_back(nobject); }
-	//GPU-ra szinkronizci
-	void SyncGPU() { if (this->Vtx().empty()) return;updateGPU();}
+	void SetUploader(BufferUploader* nuploader) { uploader = nuploader; capacity = 0; }
+	//megváltoztatás
+	void AddNew(const vec3& nobject) { MarkDirty(vtx.size(), 1); vtx.push_back(nobject); }
+	//GPU-ra szinkronizáció: csak a változott tartomány megy fel, a puffer duplázással nő
+	void SyncGPU() {
+		if (this->Vtx().empty()) return;
+		uploader->Bind(this);
+		if (vtx.size() > capacity) {
+			capacity = std::max(vtx.size(), capacity * 2);
+			uploader->Allocate(capacity * sizeof(vec3));
+			dirtyBegin = 0; dirtyEnd = vtx.size();
+		}
+		dirtyEnd = std::min(dirtyEnd, vtx.size());
+		if (dirtyBegin >= dirtyEnd) { dirtyBegin = dirtyEnd = 0; return; }
+		uploader->Upload(dirtyBegin * sizeof(vec3), (dirtyEnd - dirtyBegin) * sizeof(vec3), &vtx[dirtyBegin]);
+		dirtyBegin = dirtyEnd = 0;
+	}
 
 };
 class PointCollection : public Object {
+	Grid grid;
 public:
 	PointCollection() : Object() {}
-	//j Pont
-
-	//Kzelsgi keresse 
+	//Új Pont
+	void AddNew(const vec3& npoint) {
+		grid.Insert(grid.Cell(npoint.x, npoint.y), (int)vtx.size());
+		Object::AddNew(npoint);
+	}
+	//Közelségi keresése: csak az egér körüli 3x3 cellát nézi, a legkorábban felvett pontot adja.
+	//Az egér cellája jön először, ebben a legvalószínűbb a találat; a cellák növekvő sorrendűek, így cellánként
+	//az első találat a legkorábbi, a már talált indexen túl pedig nincs mit nézni.
 	vec3 SelectPoint(const vec3& mouse) {
-		for (const auto& point : vtx) {
-			float dx = mouse.x - point.x;
-			float dy = mouse.y - point.y;
-			float dz = mouse.z - point.z;
-			float d = sqrt(dx * dx + dy * dy + dz * dz);
-			if (d <= 0.019f) return point;
-
+		int best = -1;
+		int col = Grid::Col(mouse.x), row = Grid::Row(mouse.y);
+		auto visit = [&](int c, int r) {
+			for (int i : grid.At(c, r)) {
+				if (best >= 0 && i >= best) return;
+				const vec3& point = vtx[i];
+				float dx = mouse.x - point.x;
+				float dy = mouse.y - point.y;
+				float dz = mouse.z - point.z;
+				if (dx * dx + dy * dy + dz * dz <= 0.019f * 0.019f) { best = i; return; }
+			}
+		};
+		visit(col, row);
+		for (int r = std::max(row - 1, 0); r <= std::min(row + 1, Grid::N - 1); r++) {
+			for (int c = std::max(col - 1, 0); c <= std::min(col + 1, Grid::N - 1); c++) {
+				if (c != col || r != row) visit(c, r);
+			}
 		}
+		if (best >= 0) return vtx[best];
 		return vec3(0.0f, 0.0f, 0.0f);
 	}
-	//Felrajzols kapott sznnel(10 vastagsg, max intenzits piros)
+	//Az utoljára felvett pont törlése (visszavonáshoz)
+	void RemoveLast() {
+		if (vtx.empty()) return;
+		grid.Remove(grid.Cell(vtx.back().x, vtx.back().y), (int)vtx.size() - 1);
+		vtx.pop_back();
+	}
+	//Mentés/betöltés: a csúcstömb egyben, elemenkénti feldolgozás nélkül
+	bool Write(FILE* file) { return vtx.empty() || fwrite(&vtx[0], sizeof(vec3), vtx.size(), file) == vtx.size(); }
+	void Read(const vec3* data, size_t n) {
+		size_t first = vtx.size();
+		vtx.insert(vtx.end(), data, data + n);
+		for (size_t i = first; i < vtx.size(); i++) grid.Insert(grid.Cell(vtx[i].x, vtx[i].y), (int)i);
+		MarkDirty(first, n);
+	}
+	//Felrajzolás kapott színnel(10 vastagság, max intenzitású piros)
 	void DrawPoints(GPUProgram* prog) { glPointSize(10.0f); Draw(prog, GL_POINTS, vec3(1.0f, 0.0f, 0.0f)); }
 };
 
@@ -92,20 +217,52 @@ public:
 			corners.push_back(vec3(np1.x, -1.0f, 1.0f));
 			corners.push_back(vec3(np1.x, 1.0f, 1.0f));
 		}
-		
+		//ha a vágás nem adott két véges pontot (nem véges együtthatók), a csúcsok NaN helyett a definiáló pontok
+		if (corners.size() < 2) {
+			corners.clear();
+			corners.push_back(np1);
+			corners.push_back(np2);
+		}
 		p1 = corners[0];
 		p2 = corners[1];
 
-		printf("Line added\n");
-		printf("Implicit: %fx+%fy+%f= 0\n", A, B, C);
-		printf("Parametric:P(t) = (%f, %f) + (%f, %f)t)\n", normalp1.x, normalp1.y, dir.x, dir.y);
+		LOG(LOG_INFO, LOG_EDIT, "Line added, implicit: %fx+%fy+%f= 0, parametric: P(t) = (%f, %f) + (%f, %f)t",
+			A, B, C, normalp1.x, normalp1.y, dir.x, dir.y);
 	}
-	vec3 CrossPoint(const Line other) {
-
-		float x = (other.C * B - C * other.B) / (A * other.B - other.A * B);
-		float y = (C * other.A - other.C * A) / (other.B * A - B * other.A);
-		return vec3(x, y, 1.0f);
-
+	//Fájlból betöltött egyenes: a vágott végpontok már ismertek, nincs vágás és kiírás
+	Line(const vec3& np1, const vec3& np2, const vec3& cp1, const vec3& cp2) : p1(cp1), p2(cp2), normalp1(np1), normalp2(np2) {
+		A = np2.y - np1.y;
+		B = np1.x - np2.x;
+		C = np2.x * np1.y - np1.x * np2.y;
+		dir = normalize(np2 - np1);
+	}
+	//Metszéspont szűrt pontossággal. Ha a float nevező a kerekítési hibakorláton kívül esik, a gyors float eredmény marad
+	//(bitre azonos a szűrés nélküli képlettel); különben a definiáló pontokból double-ben, fma-val kompenzált
+	//determinánssal számol (Dekker/Shewchuk-féle szűrő). Párhuzamos (vagy elfajuló) egyeneseknél false, így NaN/inf
+	//nem kerülhet a csúcspufferbe.
+	bool Intersect(const Line& other, vec3& p) const {
+		float ab = A * other.B, ba = other.A * B, den = ab - ba;
+		float nx = other.C * B - C * other.B, ny = C * other.A - other.C * A;
+		//a végesség a számlálókból is látszik: így a döntés nem várja meg az osztásokat
+		if (fabs(den) > 5e-7f * fabs(ab + ba) && fabs(nx) + fabs(ny) < fabs(den) * std::numeric_limits<float>::max()) {
+			p = vec3(nx / den, ny / den, 1.0f);
+			return true;
+		}
+		p = IntersectExact(other);
+		return p.z != 0.0f;
+	}
+	//A szűrőn fennakadt pár a definiáló pontokból, double-ben. Érték szerint ad vissza, hogy a hívó p-je a gyors
+	//ágon regiszterben maradhasson; párhuzamos egyeneseknél (vagy ha a pont nem ábrázolható) z = 0.
+	NOINLINE vec3 IntersectExact(const Line& other) const {
+		double a1 = (double)normalp2.y - normalp1.y, b1 = (double)normalp1.x - normalp2.x;
+		double c1 = (double)normalp2.x * normalp1.y - (double)normalp1.x * normalp2.y;
+		double a2 = (double)other.normalp2.y - other.normalp1.y, b2 = (double)other.normalp1.x - other.normalp2.x;
+		double c2 = (double)other.normalp2.x * other.normalp1.y - (double)other.normalp1.x * other.normalp2.y;
+		double q1 = a1 * b2, q2 = a2 * b1;
+		double d = (q1 - q2) + (std::fma(a1, b2, -q1) - std::fma(a2, b1, -q2));
+		if (d == 0.0) return vec3(0.0f, 0.0f, 0.0f);
+		vec3 p((float)((c2 * b1 - c1 * b2) / d), (float)((c1 * a2 - c2 * a1) / d), 1.0f);
+		return std::isfinite(p.x) && std::isfinite(p.y) ? p : vec3(0.0f, 0.0f, 0.0f);
 	}
 	bool onLine(const vec3& mouse) {
 		float d = abs(A * mouse.x + B * mouse.y + C) / sqrt(A * A + B * B);
@@ -122,7 +279,7 @@ public:
 		B = normalp1.x - normalp2.x;
 		C = normalp2.x * normalp1.y - normalp1.x * normalp2.y;
 		dir = normalize(normalp2 - normalp1);
-		printf("%fx+%fy+%fc\n", A, B, C);
+		LOG(LOG_DEBUG, LOG_DRAG, "%fx+%fy+%fc", A, B, C);
 	}
 	vec3 getP1() { return p1; }
 	vec3 getP2() { return p2; }
@@ -134,60 +291,517 @@ public:
 	float getC() { return C; }
 };
 
+//Az egyenesek A, B, C együtthatói és a normálvektor hossza (N) oszloponként tárolva (SoA), a tömeges távolság- és
+//metszésszámításhoz. AVX2-vel fordítva 8 egyenest számol egyszerre, egyébként skalárisan; a távolság az onLine,
+//a metszés az Intersect float ágának képleteit követi.
+class LineCoeffs {
+	std::vector<float> A, B, C, N;
+public:
+	void Set(int i, Line& line) {
+		if (i >= (int)A.size()) { A.resize(i + 1); B.resize(i + 1); C.resize(i + 1); N.resize(i + 1); }
+		A[i] = line.getA(); B[i] = line.getB(); C[i] = line.getC();
+		N[i] = sqrt(A[i] * A[i] + B[i] * B[i]);
+	}
+	//Az n egyenes (SoA tömbök) közül az első, amelyhez az egér 0.01-nél közelebb van (-1, ha nincs).
+	//Elfajuló egyenesnél (N = 0) a hányados NaN vagy végtelen, az nem találat, mint az onLine-ban.
+	static int FirstOnLine(const vec3& mouse, const float* A, const float* B, const float* C, const float* N, int n) {
+		int k = 0;
+#ifdef __AVX2__
+		__m256 mx = _mm256_set1_ps(mouse.x), my = _mm256_set1_ps(mouse.y);
+		__m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)), limit = _mm256_set1_ps(0.01f);
+		for (; k + 8 <= n; k += 8) {
+			__m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(A + k), mx), _mm256_mul_ps(_mm256_loadu_ps(B + k), my)),
+				_mm256_loadu_ps(C + k));
+			__m256 d = _mm256_div_ps(_mm256_and_ps(e, absmask), _mm256_loadu_ps(N + k));
+			int hits = _mm256_movemask_ps(_mm256_cmp_ps(d, limit, _CMP_LT_OQ));
+			if (hits == 0) continue;
+			int j = 0;
+			while (!(hits & 1)) { hits >>= 1; j++; }
+			return k + j;
+		}
+#endif
+		for (; k < n; k++) {
+			if (fabs(A[k] * mouse.x + B[k] * mouse.y + C[k]) / N[k] < 0.01f) return k;
+		}
+		return -1;
+	}
+	//A [first, first + n) egyenesek közül az első (legkisebb azonosítójú) az egér közelében, vagy -1
+	int FirstOnLine(const vec3& mouse, int first, int n) {
+		if (n <= 0) return -1;
+		int k = FirstOnLine(mouse, &A[first], &B[first], &C[first], &N[first], n);
+		return k < 0 ? -1 : first + k;
+	}
+	//Az l egyenes metszéspontja a [first, first+n) egyenesekkel; (közel) párhuzamos párnál x = NaN.
+	//Igaz, ha volt ilyen pár (a hívónak csak ekkor kell a NaN-okat keresnie).
+	bool CrossPoints(int l, int first, int n, float* x, float* y) {
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		int flagged = 0;
+		float la = A[l], lb = B[l], lc = C[l], ls = fabs(la) + fabs(lb);
+		const float *pa = &A[first], *pb = &B[first], *pc = &C[first];
+		int k = 0;
+#ifdef __AVX2__
+		__m256 a1 = _mm256_set1_ps(la), b1 = _mm256_set1_ps(lb), c1 = _mm256_set1_ps(lc), s1 = _mm256_set1_ps(ls);
+		__m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)), eps = _mm256_set1_ps(1e-6f);
+		for (; k + 8 <= n; k += 8) {
+			__m256 a2 = _mm256_loadu_ps(pa + k), b2 = _mm256_loadu_ps(pb + k), c2 = _mm256_loadu_ps(pc + k);
+			__m256 den = _mm256_sub_ps(_mm256_mul_ps(a1, b2), _mm256_mul_ps(a2, b1));
+			__m256 s2 = _mm256_add_ps(_mm256_and_ps(a2, absmask), _mm256_and_ps(b2, absmask));
+			__m256 ok = _mm256_cmp_ps(_mm256_and_ps(den, absmask), _mm256_mul_ps(eps, _mm256_mul_ps(s1, s2)), _CMP_GT_OQ);
+			__m256 px = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(c2, b1), _mm256_mul_ps(c1, b2)), den);
+			__m256 py = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(c1, a2), _mm256_mul_ps(c2, a1)),
+				_mm256_sub_ps(_mm256_mul_ps(b2, a1), _mm256_mul_ps(b1, a2)));
+			_mm256_storeu_ps(x + k, _mm256_blendv_ps(_mm256_set1_ps(nan), px, ok));
+			flagged |= ~_mm256_movemask_ps(ok) & 0xff;
+			_mm256_storeu_ps(y + k, py);
+		}
+#endif
+		for (; k < n; k++) {
+			float den = la * pb[k] - pa[k] * lb;
+			if (fabs(den) <= 1e-6f * ls * (fabs(pa[k]) + fabs(pb[k]))) { x[k] = nan; y[k] = nan; flagged = 1; continue; }
+			x[k] = (pc[k] * lb - lc * pb[k]) / den;
+			y[k] = (lc * pa[k] - pc[k] * la) / (pb[k] * la - lb * pa[k]);
+		}
+		return flagged != 0;
+	}
+};
+
+//Az egyenesek indexe a Hough-térben: a normálvektor szöge (th, [0, pi)) és az origótól vett előjeles távolság (rho)
+//szerinti rács, cos(th)*x + sin(th)*y = rho. Minden egyenes pontosan egy cellában van, a cellán belül az azonosítók
+//növekvő sorrendben. Egy pont th szögnél rho = cos(th)*x + sin(th)*y-ra esik, ez egy szögsávon belül legfeljebb
+//|pont| * sávszélesség/2-vel változik, így sávonként csak néhány rho-cellát kell megnézni, a jelöltek száma
+//nem függ az egyenesek számától. A legkisebb azonosítójú találat cellánként az első, a már talált azonosítón túl
+//nincs mit nézni.
+class LineIndex {
+	enum { angles = 64, offsets = 160 };
+	const float maxOffset = 1.6f; //ennél távolabbi egyenes nem halad át az ablakon, a szélső cellákba kerül
+	//A cellák az egyenesek együtthatóinak másolatát is tárolják oszloponként, így egy cella jelöltjeit
+	//a LineCoeffs::FirstOnLine kernel folytonos olvasással nézi végig
+	struct Bucket {
+		std::vector<int> id;
+		std::vector<float> A, B, C, N;
+		size_t Find(int key) { return std::lower_bound(id.begin(), id.end(), key) - id.begin(); }
+	};
+	std::vector<Bucket> cells;
+	std::vector<int> cellOf; //egyenesenként a cellája; -1, ha elfajuló (nincs indexelve)
+	float angleCos[angles], angleSin[angles]; //a szögsávok közepének koszinusza és szinusza
+
+	static float AngleStep() { return float(M_PI) / angles; }
+	int OffsetBin(float rho) {
+		int o = (int)floor((rho + maxOffset) * (offsets / (2.0f * maxOffset)));
+		return o < 0 ? 0 : (o >= offsets ? offsets - 1 : o);
+	}
+	int Cell(float A, float B, float C) {
+		float n = sqrt(A * A + B * B);
+		if (!(n > 0.0f) || !std::isfinite(C)) return -1;
+		float th = atan2(B, A), rho = -C / n;
+		//(A, B) és (-A, -B) ugyanaz az egyenes: a szöget [0, pi)-be hajtjuk, rho előjele vele fordul
+		if (th < 0.0f) { th += float(M_PI); rho = -rho; }
+		int a = (int)(th / AngleStep());
+		if (a >= angles) { a = 0; rho = -rho; }
+		return a * offsets + OffsetBin(rho);
+	}
+public:
+	LineIndex() : cells(angles * offsets) {
+		for (int a = 0; a < angles; a++) {
+			angleCos[a] = cos((a + 0.5f) * AngleStep());
+			angleSin[a] = sin((a + 0.5f) * AngleStep());
+		}
+	}
+	void Insert(int id, float A, float B, float C) {
+		if (id >= (int)cellOf.size()) cellOf.resize(id + 1, -1);
+		int cell = cellOf[id] = Cell(A, B, C);
+		if (cell < 0) return;
+		Bucket& c = cells[cell];
+		size_t k = c.id.empty() || c.id.back() < id ? c.id.size() : c.Find(id);
+		c.id.insert(c.id.begin() + k, id);
+		c.A.insert(c.A.begin() + k, A);
+		c.B.insert(c.B.begin() + k, B);
+		c.C.insert(c.C.begin() + k, C);
+		c.N.insert(c.N.begin() + k, sqrt(A * A + B * B));
+	}
+	void Remove(int id) {
+		int cell = cellOf[id];
+		cellOf[id] = -1;
+		if (cell < 0) return;
+		Bucket& c = cells[cell];
+		size_t k = c.Find(id);
+		c.id.erase(c.id.begin() + k);
+		c.A.erase(c.A.begin() + k);
+		c.B.erase(c.B.begin() + k);
+		c.C.erase(c.C.begin() + k);
+		c.N.erase(c.N.begin() + k);
+	}
+	//Az egyenes új együtthatói; ha a cellája nem változik, csak a másolatot írjuk át
+	void Update(int id, float A, float B, float C) {
+		int cell = Cell(A, B, C);
+		if (cell < 0 || cell != cellOf[id]) {
+			Remove(id);
+			Insert(id, A, B, C);
+			return;
+		}
+		Bucket& c = cells[cell];
+		size_t k = c.Find(id);
+		c.A[k] = A; c.B[k] = B; c.C[k] = C; c.N[k] = sqrt(A * A + B * B);
+	}
+	//A legkisebb azonosítójú egyenes, amelyhez az egér 0.01-nél közelebb van (-1, ha nincs), az onLine képletével.
+	//Előbb szögsávonként az egérhez tartozó rho cellája jön, ebben a legvalószínűbb a találat; a többi cellában
+	//utána már csak a talált azonosítónál kisebbeket kell megnézni.
+	int First(const vec3& mouse) {
+		int best = -1;
+		auto visit = [&](int cell) {
+			Bucket& c = cells[cell];
+			if (c.id.empty() || (best >= 0 && c.id[0] >= best)) return;
+			int n = best >= 0 ? (int)c.Find(best) : (int)c.id.size();
+			int k = LineCoeffs::FirstOnLine(mouse, &c.A[0], &c.B[0], &c.C[0], &c.N[0], n);
+			if (k >= 0) best = c.id[k];
+		};
+		//a float kerekítés miatt a tűrés kicsit bővebb, a pontos döntés a fenti képleté
+		float reach = sqrt(mouse.x * mouse.x + mouse.y * mouse.y) * 0.5f * AngleStep() + 0.0101f;
+		float rho[angles];
+		for (int a = 0; a < angles; a++) {
+			rho[a] = angleCos[a] * mouse.x + angleSin[a] * mouse.y;
+			visit(a * offsets + OffsetBin(rho[a]));
+		}
+		for (int a = 0; a < angles; a++) {
+			int center = OffsetBin(rho[a]), o1 = OffsetBin(rho[a] + reach);
+			for (int o = OffsetBin(rho[a] - reach); o <= o1; o++) if (o != center) visit(a * offsets + o);
+		}
+		return best;
+	}
+};
+
 class LineCollection : public Object {
+	enum { scanFirst = 4096 }; //ennyi egyenest a kijelölés előbb sorban, a FirstOnLine kernellel néz végig
 	std::vector<Line> lines;
+	LineCoeffs coeffs;
+	LineIndex index;
 public:
 	LineCollection() : Object() {}
-	//j egyenes
+	//Új egyenes
 	void AddNew(Line nline) {
+		int id = (int)lines.size();
 		lines.push_back(nline);
-		vtx.push_back(nline.getP1()); vtx.push_back(nline.getP2());
+		coeffs.Set(id, lines[id]);
+		index.Insert(id, lines[id].getA(), lines[id].getB(), lines[id].getC());
+		Object::AddNew(nline.getP1()); Object::AddNew(nline.getP2());
 	}
-	//Kzelsgi keresse	
-	Line* SelectLine(const vec3& mouse) {
-		for (size_t i = 0; i < lines.size(); i++) {
-			if (lines[i].onLine(mouse)) { return &lines[i]; }
+	//Közelségi keresés; a legkorábban felvett találatot adja, mint a lineáris keresés.
+	//Az egyenes azonosítóját adja (-1, ha nincs): ez a felvétel sorszáma, a csúcsai Vtx()[2*id] és Vtx()[2*id+1],
+	//és újabb egyenesek felvétele után is érvényes marad (a Line* a vektor átméretezésekor elavulna).
+	//Az első scanFirst egyenest sorban nézzük: ez kevés egyenesnél, és sűrű jelenetben, ahol a találat korán jön,
+	//gyorsabb a Hough-térbeli indexnél. Ha itt nincs találat, az index adja a többit; az is a legkisebb azonosítót
+	//keresi, és scanFirst alatt nincs találat, így az eredmény ugyanaz.
+	int SelectLine(const vec3& mouse) {
+		int n = (int)lines.size(), id = coeffs.FirstOnLine(mouse, 0, std::min(n, (int)scanFirst));
+		if (id >= 0 || n <= scanFirst) return id;
+		return index.First(mouse);
+	}
+	Line& Get(int id) { return lines[id]; }
+	//Az összes páronkénti metszéspont az ablakon belül, az (i, j > i) párok sorrendjében.
+	//Szándékosan nincs söprés vagy rácsos kiválogatás: minden egyenes átéri az ablakot, így véletlen egyeneseknél
+	//a párok kb. 69%-a az ablakon belül metsz, a kimenet maga négyzetes, és egy rács több párt adna, mint amennyit
+	//kiszűr. A párokat ezért egyenként nézzük: i egyenes a j > i egyenesekkel egy-egy összefüggő tömbön (SoA) metszve. A sorokat párszám szerint egyenlő, összefüggő
+	//sávokra osztjuk a szálak között, a sávok eredménye sorrendben fűződik össze, így a kimenet nem függ a szálak számától.
+	std::vector<vec3> IntersectAll() {
+		int n = (int)lines.size();
+		double pairs = 0.5 * n * (n - 1.0);
+		int nthreads = pairs < 65536.0 ? 1 : std::max(1, (int)std::thread::hardware_concurrency());
+		std::vector<int> bands(1, 0);
+		double done = 0.0;
+		for (int i = 0; i < n && (int)bands.size() < nthreads; i++) {
+			done += n - 1 - i;
+			if (done >= pairs * bands.size() / nthreads) bands.push_back(i + 1);
 		}
-		return nullptr;
-
+		bands.push_back(n);
+		std::vector<std::vector<vec3>> results(bands.size() - 1);
+		std::vector<std::thread> workers;
+		for (size_t w = 1; w < results.size(); w++) {
+			workers.push_back(std::thread(&LineCollection::IntersectRows, this, bands[w], bands[w + 1], std::ref(results[w])));
+		}
+		IntersectRows(bands[0], bands[1], results[0]);
+		for (auto& worker : workers) worker.join();
+		if (results.size() == 1) return std::move(results[0]);
+		std::vector<vec3> crosspoints;
+		size_t total = 0;
+		for (auto& result : results) total += result.size();
+		crosspoints.reserve(total);
+		for (auto& result : results) crosspoints.insert(crosspoints.end(), result.begin(), result.end());
+		return crosspoints;
+	}
+	//Az [begin, end) egyenesek metszéspontjai a későbbi egyenesekkel
+	void IntersectRows(int begin, int end, std::vector<vec3>& out) {
+		int n = (int)lines.size();
+		std::vector<float> xs(n), ys(n);
+		for (int i = begin; i < end; i++) {
+			int m = n - i - 1;
+			if (m <= 0) break;
+			//a gyors számítás közel párhuzamosnak talált párokat (NaN) a szűrt pontos változat dönti el; a párhuzamosaknál
+			//x NaN marad, azokat az ablakvizsgálat kiszűri
+			if (coeffs.CrossPoints(i, i + 1, m, &xs[0], &ys[0])) {
+				for (int j = 0; j < m; j++) {
+					vec3 p;
+					if (xs[j] == xs[j] || !lines[i].Intersect(lines[i + 1 + j], p)) continue;
+					xs[j] = p.x; ys[j] = p.y;
+				}
+			}
+			for (int j = 0; j < m; j++) {
+				//ablakon kívüli pont
+				if (!(xs[j] >= -1.0f && xs[j] <= 1.0f && ys[j] >= -1.0f && ys[j] <= 1.0f)) continue;
+				out.push_back(vec3(xs[j], ys[j], 1.0f));
+			}
+		}
+	}
+	//Eltolás, az index és a csúcsok frissítésével
+	void Translate(int i, const vec3& np) {
+		lines[i].Translate(np);
+		coeffs.Set(i, lines[i]);
+		index.Update(i, lines[i].getA(), lines[i].getB(), lines[i].getC());
+		vtx[i * 2] = lines[i].getP1();
+		vtx[i * 2 + 1] = lines[i].getP2();
+		MarkDirty(i * 2, 2);
 	}
-	int hanyadik(Line nline) {
-		for (size_t i = 0; i < lines.size(); i++) {
-			if (lines[i].getNormalP1().x == nline.getNormalP1().x && lines[i].getNormalP1().y == nline.getNormalP1().y &&
-				lines[i].getNormalP2().x == nline.getNormalP2().x && lines[i].getNormalP2().y == nline.getNormalP2().y &&
-				lines[i].getDir().x == nline.getDir().x && lines[i].getDir().y == nline.getDir().y) return i;
+	//Mentés: a vágott végpontok (a Vtx() tartalma), utána a definiáló pontok
+	bool Write(FILE* file) {
+		if (lines.empty()) return true;
+		std::vector<vec3> defs;
+		for (auto& line : lines) { defs.push_back(line.getNormalP1()); defs.push_back(line.getNormalP2()); }
+		return fwrite(&vtx[0], sizeof(vec3), vtx.size(), file) == vtx.size() &&
+			fwrite(&defs[0], sizeof(vec3), defs.size(), file) == defs.size();
+	}
+	//Betöltés: a végpontok egyben kerülnek a csúcstömbbe, az egyeneseket nem kell újra vágni
+	void Read(const vec3* ends, const vec3* defs, size_t n) {
+		size_t first = vtx.size();
+		vtx.insert(vtx.end(), ends, ends + 2 * n);
+		lines.reserve(lines.size() + n);
+		for (size_t k = 0; k < n; k++) {
+			int id = (int)lines.size();
+			lines.push_back(Line(defs[2 * k], defs[2 * k + 1], vtx[first + 2 * k], vtx[first + 2 * k + 1]));
+			coeffs.Set(id, lines[id]);
+			index.Insert(id, lines[id].getA(), lines[id].getB(), lines[id].getC());
 		}
-		return - 1;
+		MarkDirty(first, 2 * n);
+	}
+	size_t Count() { return lines.size(); }
+	//Az utoljára felvett egyenes törlése (visszavonáshoz); a többi azonosító nem változik
+	void RemoveLast() {
+		if (lines.empty()) return;
+		int id = (int)lines.size() - 1;
+		index.Remove(id);
+		lines.pop_back();
+		vtx.pop_back(); vtx.pop_back();
 	}
 	//Rajz
 	void DrawLines(GPUProgram* prog) { glLineWidth(3.0f); Draw(prog, GL_LINES, vec3(0.0f, 1.0f, 1.0f)); }
 
 
 };
+//Bináris jelenet: fejléc, a pontok, az egyenesek vágott végpontjai, majd definiáló pontjai, mind vec3 tömbként
+struct SceneHeader {
+	char magic[4];
+	uint32_t points, lines;
+};
+bool SaveScene(const char* filename, PointCollection* points, LineCollection* lines) {
+	FILE* file = fopen(filename, "wb");
+	if (!file) return false;
+	SceneHeader header = { { 'G', 'E', 'O', '1' }, (uint32_t)points->Vtx().size(), (uint32_t)lines->Count() };
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && points->Write(file) && lines->Write(file);
+	fclose(file);
+	return ok;
+}
+//Betöltés üres gyűjteményekbe. A fájl memóriába vetítve (mmap; Windows alatt sima olvasás), és a fejléc
+//darabszámait a fájl méretéhez, a koordinátákat a végességhez mérjük, mielőtt bármi a gyűjteményekbe kerülne.
+bool LoadScene(const char* filename, PointCollection* points, LineCollection* lines) {
+	std::vector<char> buffer;
+	const char* data = nullptr;
+	size_t size = 0;
+#ifndef _WIN32
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	void* mapped = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		size = (size_t)st.st_size;
+		mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	if (mapped == MAP_FAILED) return false;
+	data = (const char*)mapped;
+#else
+	FILE* file = fopen(filename, "rb");
+	if (!file) return false;
+	fseek(file, 0, SEEK_END);
+	size = (size_t)ftell(file);
+	fseek(file, 0, SEEK_SET);
+	buffer.resize(size);
+	bool read = size > 0 && fread(&buffer[0], 1, size, file) == size;
+	fclose(file);
+	if (!read) return false;
+	data = &buffer[0];
+#endif
+	SceneHeader header;
+	bool ok = size >= sizeof(header);
+	if (ok) {
+		memcpy(&header, data, sizeof(header));
+		uint64_t need = sizeof(header) + (uint64_t(header.points) + 4 * uint64_t(header.lines)) * sizeof(vec3);
+		ok = memcmp(header.magic, "GEO1", 4) == 0 && size == need;
+	}
+	const vec3* vertices = (const vec3*)(data + sizeof(header));
+	if (ok) {
+		const float* coords = &vertices[0].x;
+		for (size_t i = 0; ok && i < (size - sizeof(header)) / sizeof(float); i++) ok = std::isfinite(coords[i]);
+	}
+	if (ok) {
+		points->Read(vertices, header.points);
+		lines->Read(vertices + header.points, vertices + header.points + 2 * size_t(header.lines), header.lines);
+	}
+#ifndef _WIN32
+	munmap((void*)data, size);
+#endif
+	return ok;
+}
+
+//Visszavonási napló: minden szerkesztés egy rögzített méretű bejegyzés, a legrégebbiek a korlát felett elvesznek.
+//A felvételek mindig a gyűjtemények végére kerülnek, ezért fordított sorrendben a végükről visszavonhatók.
+//A visszavont metszéspontokat a napló megőrzi, amíg újra végrehajthatók, így az újra sem számol metszéseket.
+class Journal {
+	enum EditType { ADD_POINT, ADD_LINE, ADD_CROSSPOINTS, TRANSLATE };
+	struct Edit {
+		EditType type = ADD_POINT;
+		int id = 0;			//egyenes azonosító, ill. a metszéspontok száma
+		bool open = false;	//folyamatban lévő húzás, a következő eltolás ebbe olvad
+		vec3 a = vec3(), b = vec3(), c = vec3(), d = vec3(); //pont; egyenes definiáló és vágott pontjai; eltolás előtti és utáni középpont
+	};
+	std::deque<Edit> edits;
+	size_t applied = 0;	//az edits elejéből ennyi van érvényben, a többi újra végrehajtható
+	std::vector<std::vector<vec3>> undoneCrossPoints; //a visszavont ADD_CROSSPOINTS bejegyzések pontjai, veremben
+	size_t limit;
+	PointCollection* points;
+	LineCollection* lines;
+
+	void Push(const Edit& edit) {
+		edits.erase(edits.begin() + applied, edits.end());
+		undoneCrossPoints.clear();
+		edits.push_back(edit);
+		if (edits.size() > limit) edits.pop_front();
+		applied = edits.size();
+	}
+public:
+	Journal(PointCollection* npoints, LineCollection* nlines, size_t nlimit = 100000) : limit(nlimit), points(npoints), lines(nlines) {}
+	void Reset(PointCollection* npoints, LineCollection* nlines) {
+		points = npoints; lines = nlines; edits.clear(); applied = 0; undoneCrossPoints.clear();
+	}
+	size_t Size() { return edits.size(); }
+	size_t Bytes() {
+		size_t bytes = edits.size() * sizeof(Edit);
+		for (auto& crosspoints : undoneCrossPoints) bytes += crosspoints.size() * sizeof(vec3);
+		return bytes;
+	}
+
+	void AddPoint(const vec3& p) { Push({ ADD_POINT, 0, false, p }); }
+	void AddLine(int id) {
+		Line& line = lines->Get(id);
+		Push({ ADD_LINE, id, false, line.getNormalP1(), line.getNormalP2(), line.getP1(), line.getP2() });
+	}
+	void AddCrossPoints(int count) { if (count > 0) Push({ ADD_CROSSPOINTS, count, false }); }
+	//Egymás utáni eltolások ugyanazon az egyenesen egy bejegyzéssé olvadnak, amíg a Close() le nem zárja
+	void Translate(int id, const vec3& from, const vec3& to) {
+		if (applied == edits.size() && applied > 0) {
+			Edit& last = edits.back();
+			if (last.type == TRANSLATE && last.open && last.id == id) { last.b = to; return; }
+		}
+		Push({ TRANSLATE, id, true, from, to });
+	}
+	void Close() { if (!edits.empty()) edits.back().open = false; }
+
+	bool Undo() {
+		if (applied == 0) return false;
+		Edit& edit = edits[--applied];
+		edit.open = false;
+		switch (edit.type) {
+		case ADD_POINT: points->RemoveLast(); break;
+		case ADD_LINE: lines->RemoveLast(); break;
+		case ADD_CROSSPOINTS:
+			undoneCrossPoints.emplace_back(points->Vtx().end() - edit.id, points->Vtx().end());
+			for (int i = 0; i < edit.id; i++) points->RemoveLast();
+			break;
+		case TRANSLATE: lines->Translate(edit.id, edit.a); break;
+		}
+		return true;
+	}
+	bool Redo() {
+		if (applied == edits.size()) return false;
+		Edit& edit = edits[applied++];
+		switch (edit.type) {
+		case ADD_POINT: points->AddNew(edit.a); break;
+		case ADD_LINE: lines->AddNew(Line(edit.a, edit.b, edit.c, edit.d)); break;
+		case ADD_CROSSPOINTS:
+			for (const vec3& p : undoneCrossPoints.back()) points->AddNew(p);
+			undoneCrossPoints.pop_back();
+			break;
+		case TRANSLATE: lines->Translate(edit.id, edit.b); break;
+		}
+		return true;
+	}
+};
+
+//Esemény-késleltetések kategóriánként, 2-hatvány mikroszekundumos vödrökben
+class LatencyStats {
+	static const int nBuckets = 24;
+	struct Category {
+		std::string name;
+		long count = 0;
+		double total = 0.0;
+		long buckets[nBuckets] = {};
+	};
+	std::vector<Category> categories;
+public:
+	void Add(const std::string& name, double seconds) {
+		Category* c = nullptr;
+		for (auto& category : categories) if (category.name == name) c = &category;
+		if (!c) { categories.push_back(Category()); c = &categories.back(); c->name = name; }
+		c->count++;
+		c->total += seconds;
+		int b = 0;
+		for (double us = seconds * 1e6; us > 1.0 && b < nBuckets - 1; us /= 2.0) b++;
+		c->buckets[b]++;
+	}
+	void Report() {
+		for (auto& c : categories) {
+			printf("%-14s %8ld events  avg %10.2f us  %12.0f events/s\n", c.name.c_str(), c.count,
+				c.total / c.count * 1e6, c.total > 0.0 ? c.count / c.total : 0.0);
+			for (int b = 0; b < nBuckets; b++) {
+				if (c.buckets[b] > 0) printf("    <= %8ld us: %ld\n", 1L << b, c.buckets[b]);
+			}
+		}
+	}
+};
+
 class GreenTriangleApp : public glApp {
 
 	PointCollection* points;
-	GPUProgram* gpuProgram;	   // cscspont s pixel rnyalk
+	GPUProgram* gpuProgram;	   // csúcspont és pixel árnyalók
 	LineCollection* lines;
+	Journal* journal;
 	std::vector<vec3> pointsbuffer;
-	std::vector<Line*> linesbuffer;
-	Line* selectedLine;
+	std::vector<int> linesbuffer;
+	int selectedLine = -1;
 	bool moving = false;
 	int mode;
 public:
 	GreenTriangleApp() : glApp("Green triangle") {}
-	// Inicializci, 
+	// Inicializáció, 
 	void onInitialization() {
 		points = new PointCollection();
 		lines = new LineCollection();
+		journal = new Journal(points, lines);
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 
 	}
 
-	// Ablak jrarajzols
+	// Ablak újrarajzolás
 	void onDisplay() {
-		glClearColor(0.4f, 0.4f, 0.4f, 0.0f);     // httr szn
-		glClear(GL_COLOR_BUFFER_BIT); // rasztertr trls
+		glClearColor(0.4f, 0.4f, 0.4f, 0.0f);     // háttér szín
+		glClear(GL_COLOR_BUFFER_BIT); // rasztertár törlés
 		glViewport(0, 0, winWidth, winHeight);
 		//triangle->Draw(gpuProgram, GL_TRIANGLES, vec3(0.0f, 1.0f, 0.0f));
 		lines->DrawLines(gpuProgram);
@@ -195,10 +809,55 @@ public:
 
 	}
 	void onKeyboard(int key) {
-		if (key == 'p') {  mode = 'p'; printf("Point creator\n"); }
-		if (key == 'l') { mode = 'l'; printf("Line creator\n"); }
-		if (key == 'm') { mode = 'm'; printf("Move\n"); }
-		if (key == 'i') { mode = 'i'; printf("Intersect\n"); }
+		if (key == 'p') {  mode = 'p'; LOG(LOG_INFO, LOG_GENERAL, "Point creator"); }
+		if (key == 'l') { mode = 'l'; LOG(LOG_INFO, LOG_GENERAL, "Line creator"); }
+		if (key == 'm') { mode = 'm'; LOG(LOG_INFO, LOG_GENERAL, "Move"); }
+		if (key == 'i') { mode = 'i'; LOG(LOG_INFO, LOG_GENERAL, "Intersect"); }
+		//visszavonás / újra; a félbehagyott kijelölések az azonosítók változása miatt elvesznek
+		if ((key == 'z' && journal->Undo()) || (key == 'y' && journal->Redo())) {
+			linesbuffer.clear(); pointsbuffer.clear(); selectedLine = -1; moving = false;
+			points->SyncGPU();
+			lines->SyncGPU();
+			refreshScreen();
+		}
+		if (key == 'r') Replay("geometria_replay.txt");
+		if (key == 's') {
+			if (SaveScene("geometria_scene.bin", points, lines)) LOG(LOG_INFO, LOG_GENERAL, "Scene saved");
+			else LOG(LOG_ERROR, LOG_GENERAL, "Scene save failed");
+		}
+		//részletes (debug) napló ki/be, a húzás üzeneteiből csak minden 8.
+		if (key == 'v') {
+			eventLog().SetLevel(eventLog().Level() == LOG_DEBUG ? LOG_INFO : LOG_DEBUG);
+			eventLog().SetSampling(LOG_DRAG, 8);
+		}
+		//betöltés új gyűjteményekbe; sikertelen betöltésnél a jelenet és a napló marad
+		if (key == 'o') {
+			PointCollection* npoints = new PointCollection();
+			LineCollection* nlines = new LineCollection();
+			if (LoadScene("geometria_scene.bin", npoints, nlines)) {
+				delete points; delete lines;
+				points = npoints;
+				lines = nlines;
+				journal->Reset(points, lines);
+				linesbuffer.clear(); pointsbuffer.clear(); selectedLine = -1; moving = false;
+				points->SyncGPU();
+				lines->SyncGPU();
+				refreshScreen();
+				LOG(LOG_INFO, LOG_GENERAL, "Scene loaded");
+			}
+			else {
+				delete npoints; delete nlines;
+				LOG(LOG_ERROR, LOG_GENERAL, "Scene load failed");
+			}
+		}
+		if (key == 'a') {
+			std::vector<vec3> crosspoints = lines->IntersectAll();
+			for (const vec3& p : crosspoints) points->AddNew(p);
+			journal->AddCrossPoints((int)crosspoints.size());
+			points->SyncGPU();
+			refreshScreen();
+			LOG(LOG_INFO, LOG_EDIT, "Intersect all: %d points added", (int)crosspoints.size());
+		}
 	}
 	void onMousePressed(MouseButton button, int pX, int pY) {
 
@@ -208,8 +867,9 @@ public:
 			vec3 mouse = vec3((2.0f * pX) / winWidth - 1.0f, 1.0f - 2.0f * pY / winHeight, 1.0f);
 
 			if (mode == 'p') {
-				printf("Point: %f, %f added\n", mouse.x, mouse.y);
+				LOG(LOG_INFO, LOG_EDIT, "Point: %f, %f added", mouse.x, mouse.y);
 				points->AddNew(mouse);
+				journal->AddPoint(mouse);
 				points->SyncGPU();
 				refreshScreen();
 			}
@@ -220,6 +880,7 @@ public:
 					pointsbuffer.push_back(points->SelectPoint(mouse));
 					if (pointsbuffer.size() == 2) {
 						lines->AddNew(Line(pointsbuffer[0], pointsbuffer[1]));
+						journal->AddLine((int)lines->Count() - 1);
 						pointsbuffer.clear();
 						lines->SyncGPU();
 						refreshScreen();
@@ -228,11 +889,16 @@ public:
 				}
 
 			if (mode == 'i') {
-				if (lines->SelectLine(mouse)) {
-					Line* selectedLine = lines->SelectLine(mouse);
-					if (selectedLine->onLine(mouse)) linesbuffer.push_back(selectedLine);
+				int id = lines->SelectLine(mouse);
+				if (id >= 0) {
+					linesbuffer.push_back(id);
 					if (linesbuffer.size() == 2) {
-						points->AddNew(linesbuffer[0]->CrossPoint(*linesbuffer[1]));
+						vec3 crosspoint;
+						if (lines->Get(linesbuffer[0]).Intersect(lines->Get(linesbuffer[1]), crosspoint)) {
+							points->AddNew(crosspoint);
+							journal->AddPoint(crosspoint);
+						}
+						else LOG(LOG_WARN, LOG_EDIT, "Parallel lines, no intersection");
 						linesbuffer.clear();
 						points->SyncGPU();
 						refreshScreen();
@@ -241,10 +907,8 @@ public:
 
 			}
 			if (mode == 'm') {
-				if (lines->SelectLine(mouse)) {
-					moving = true;
-					selectedLine = lines->SelectLine(mouse);
-				}
+				selectedLine = lines->SelectLine(mouse);
+				moving = selectedLine >= 0;
 			}
 		}
 
@@ -254,22 +918,66 @@ public:
 		if (moving) {
 			vec3 mouse = vec3(2.0f * pX / winWidth - 1.0f, 1.0f - 2.0f * pY / winHeight, 1.0f);
 
-			int pos = lines->hanyadik(*selectedLine);
-			if (selectedLine) {
-				selectedLine->Translate(mouse);
-				lines->Vtx()[pos * 2] = selectedLine->getP1();
-				lines->Vtx()[pos * 2 + 1] = selectedLine->getP2();
+			int pos = selectedLine;
+			if (pos >= 0) {
+				Line& line = lines->Get(pos);
+				journal->Translate(pos, (line.getNormalP1() + line.getNormalP2()) / 2.0f, mouse);
+				lines->Translate(pos, mouse);
 				lines->SyncGPU();
 				refreshScreen();
-				printf("Updated Line: %f, %f -> %f, %f\n",
+				LOG(LOG_DEBUG, LOG_DRAG, "Updated Line: %f, %f -> %f, %f",
 					lines->Vtx()[pos * 2].x, lines->Vtx()[pos * 2].y,
 					lines->Vtx()[pos * 2 + 1].x, lines->Vtx()[pos * 2 + 1].y);
 			}
 		}
 	}
+	//Esemény-visszajátszás fájlból, a feltöltések csak számolva (nem mennek a GPU-ra).
+	//Soronként: "k <billentyű>", "p x y" lenyomás, "m x y" mozgatás, "r x y" felengedés (pixelben), "#" megjegyzés
+	void Replay(const char* filename) {
+		FILE* file = fopen(filename, "r");
+		if (!file) { LOG(LOG_ERROR, LOG_GENERAL, "Cannot open %s", filename); return; }
+		CountingUploader uploader;
+		points->SetUploader(&uploader);
+		lines->SetUploader(&uploader);
+		LatencyStats stats;
+		char type;
+		auto begin = std::chrono::steady_clock::now();
+		while (fscanf(file, " %c", &type) == 1) {
+			char key = 0;
+			int pX = 0, pY = 0;
+			if (type == '#' || (type == 'k' && fscanf(file, " %c", &key) != 1) ||
+				(type != 'k' && fscanf(file, "%d %d", &pX, &pY) != 2)) {
+				for (int c = fgetc(file); c != '\n' && c != EOF; c = fgetc(file));
+				continue;
+			}
+			if (type == 'k' && key == 'r') continue;
+			std::string name;
+			if (type == 'k') name = key == 'a' ? "intersect-all" : "key";
+			if (type == 'p') name = mode == 'p' ? "point" : mode == 'l' ? "line" : mode == 'i' ? "intersect" : "pick";
+			if (type == 'm') name = moving ? "drag" : "motion";
+			if (type == 'r') name = "release";
+			auto start = std::chrono::steady_clock::now();
+			if (type == 'k') onKeyboard(key);
+			if (type == 'p') onMousePressed(MOUSE_LEFT, pX, pY);
+			if (type == 'm') onMouseMotion(pX, pY);
+			if (type == 'r') onMouseReleased(MOUSE_LEFT, pX, pY);
+			stats.Add(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		fclose(file);
+		points->SetUploader(&glUploader);
+		lines->SetUploader(&glUploader);
+		points->SyncGPU();
+		lines->SyncGPU();
+		stats.Report();
+		printf("Replay: %.3f s, %zu bytes uploaded, %zu points, %zu line vertices\n",
+			total, uploader.uploaded, points->Vtx().size(), lines->Vtx().size());
+		refreshScreen();
+	}
 	void onMouseReleased(MouseButton button, int pX, int pY) {
 		if (button == MOUSE_LEFT) {
 			moving = false;
+			journal->Close();
 		}
 		
 	}
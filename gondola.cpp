@@ -1,28 +1,39 @@
 //=============================================================================================
-// Zld hromszg: A framework.h osztlyait felhasznl megolds
+// Zöld háromszög: A framework.h osztályait felhasználó megoldás
 //=============================================================================================
 #include "framework.h"
+#include "naplo.h"
+#include <thread>
+#include <atomic>
+#include <cstdint>
 
-// cscspont rnyal
+// csúcspont árnyaló
 const char * vertSource = R"(
 	#version 330				
     precision highp float;
 
-	uniform mat4 MVP; 	// Modell-Nzeti-Perspektv transzformci
+	uniform mat4 MVP; 	// Modell-Nézeti-Perspektív transzformáció
+	uniform bool instanced;	// példányonkénti eltolás és elforgatás
 	layout(location = 0) in vec2 vp; // 0. bemeneti regiszter
+	layout(location = 1) in vec3 instance; // példány: x, y eltolás, z elforgatási szög
 
 	void main() {
-   gl_Position = MVP * vec4(vp.xy, 0, 1); 	
+		vec2 p = vp.xy;
+		if (instanced) {
+			float c = cos(instance.z), s = sin(instance.z);
+			p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + instance.xy;
+		}
+   gl_Position = MVP * vec4(p, 0, 1); 	
 	}
 )";
 
-// pixel rnyal
+// pixel árnyaló
 const char * fragSource = R"(
 	#version 330
     precision highp float;
 
-	uniform vec3 color;			// konstans szn
-	out vec4 fragmentColor;		// pixel szn
+	uniform vec3 color;			// konstans szín
+	out vec4 fragmentColor;		// pixel szín
 
 	void main() {
 		fragmentColor = vec4(color, 1); // RGB -> RGBA
@@ -31,36 +42,79 @@ const char * fragSource = R"(
 
 const int winWidth = 600, winHeight = 600;
 
+//Nézeti ablak a világban: középpont és fél-méret. A mátrixokat és inverzeiket csak változás után számoljuk újra.
 class Camera {
 	vec3 wCenter; 
 	vec3 wSize;   
+	mat4 view, projection, viewInverse, projectionInverse, viewProjection;
+	bool dirty = true;
 
+	void Update() {
+		if (!dirty) return;
+		view = translate(-wCenter);
+		projection = scale(vec3(1.0f / wSize.x, 1.0f / wSize.y, 1.0f));
+		viewInverse = translate(wCenter);
+		projectionInverse = scale(vec3(wSize.x, wSize.y, 1.0f));
+		viewProjection = projection * view;
+		dirty = false;
+	}
 public:
 	Camera(vec3 center, vec3 size) : wCenter(center), wSize(size) {}
-	mat4 V() {return translate(-wCenter);}
-	mat4 P() {return scale(vec3(1.0f / wSize.x, 1.0f / wSize.y, 1.0f));}
-	//mat4 Vinv() { return inverse(V()); }
-	//mat4 Pinv() {return inverse(P());}
+	mat4 V() { Update(); return view; }
+	mat4 P() { Update(); return projection; }
+	mat4 Vinv() { Update(); return viewInverse; }
+	mat4 Pinv() { Update(); return projectionInverse; }
+	mat4 VP() { Update(); return viewProjection; }
+	//factor < 1 nagyít, > 1 kicsinyít, a középpont helyben marad
+	void Zoom(float factor) { wSize = vec3(wSize.x * factor, wSize.y * factor, wSize.z); dirty = true; }
+	void Pan(vec3 offset) { wCenter += vec3(offset.x, offset.y, 0.0f); dirty = true; }
+	vec3 Size() { return wSize; }
+	//Látszik-e valami a [bmin, bmax] világbeli téglalapból
+	bool Visible(vec3 bmin, vec3 bmax) {
+		return bmax.x >= wCenter.x - wSize.x && bmin.x <= wCenter.x + wSize.x &&
+			bmax.y >= wCenter.y - wSize.y && bmin.y <= wCenter.y + wSize.y;
+	}
 	vec3 ScreenToWorld(vec3 screenPos) {
 		float normalizedX = (2.0f * screenPos.x) / winWidth - 1.0f;
 		float normalizedY = 1.0f - (2.0f * screenPos.y) / winHeight; 
-		float normalizedZ = screenPos.z;
-		//c4 worldPos = Vinv() * Pinv() * vec4(normalizedX, normalizedY, normalizedZ, 1.0f);
-		//vec4 worldPos = Vinv() * vec4(screenPos.x,screenPos.y,screenPos.z, 1.0f);
-		//worldPos = Vinv() * worldPos; 
-		//return vec3(worldPos.x, worldPos.y, worldPos.z);
-		return(vec3(normalizedX * 20, normalizedY * 20, normalizedZ * 20));
+		vec4 worldPos = Vinv() * Pinv() * vec4(normalizedX, normalizedY, screenPos.z, 1.0f);
+		return vec3(worldPos.x, worldPos.y, worldPos.z);
 	}
 };
 
 Camera* camera;
 
-class Primitive2D {
-	unsigned int vao, vbo;	
-protected:
-	std::vector<vec3> vtx;	
+//A csúcspufferekkel és a rajzolással kapcsolatos GL hívások egy helyen: a GLBackend a valódi, a CountingBackend GL nélkül
+//csak számol, így ellenőrizhető, hogy a változatlan képkockák nem töltenek fel semmit, a SoftwareRenderer pedig
+//a processzoron rajzol. A rajzoló hívások a csúcsok CPU-s másolatát (vtx) is megkapják, a GL ezt nem használja.
+class RenderBackend {
 public:
-	Primitive2D() {
+	//Új VAO és VBO, a 0. attribútum (vec3) a VBO-ból olvas
+	virtual void GenVertexArray(unsigned int& vao, unsigned int& vbo) = 0;
+	//A puffer újrafoglalása bytes méretre; data == NULL esetén tartalom nélkül
+	virtual void BufferData(unsigned int vbo, size_t bytes, const void* data) = 0;
+	//A puffer [offset, offset + bytes) tartományának felülírása
+	virtual void BufferSubData(unsigned int vbo, size_t offset, size_t bytes, const void* data) = 0;
+	//Példányadatok az 1. attribútumba; az instanceVbo első használatkor jön létre
+	virtual void InstanceData(unsigned int vao, unsigned int& instanceVbo, size_t bytes, const void* data) = 0;
+	virtual void DeleteVertexArray(unsigned int vao, unsigned int vbo, unsigned int instanceVbo) = 0;
+	//Vonalvastagság és pontméret a következő rajzolásokhoz
+	virtual void LineWidth(float w) = 0;
+	virtual void PointSize(float s) = 0;
+	//Az árnyaló MVP mátrixa és színe a következő rajzolásokhoz
+	virtual void Uniforms(GPUProgram* prog, const mat4& MVP, vec3 color) = 0;
+	//A csúcsok [first, first + count) tartománya, a CPU-n vtx[first]-től
+	virtual void DrawArrays(unsigned int vao, int type, int first, int count, const vec3* vtx) = 0;
+	//Tartományok egy hívással: a pufferben base + first[k]-tól, a CPU-n vtx[first[k]]-tól
+	virtual void MultiDrawArrays(unsigned int vao, int type, const int* first, const int* count, int drawcount, int base, const vec3* vtx) = 0;
+	//Példányonként (x, y eltolás, z szög) ugyanaz a tartomány
+	virtual void DrawArraysInstanced(unsigned int vao, int type, int first, int count, int instancecount, const vec3* vtx, const vec3* instances) = 0;
+	virtual ~RenderBackend() {}
+};
+class GLBackend : public RenderBackend {
+	GPUProgram* program = nullptr; //a legutóbbi Uniforms programja, a példányos rajzolás kapcsolójához
+public:
+	void GenVertexArray(unsigned int& vao, unsigned int& vbo) {
 		glGenVertexArrays(1, &vao);
 		glBindVertexArray(vao);
 		glGenBuffers(1, &vbo);
@@ -68,183 +122,760 @@ public:
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
 	}
-	std::vector<vec3>& Vtx() { return vtx; }
-	void Load() {
-		glBindVertexArray(vao); glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	void BufferData(unsigned int vbo, size_t bytes, const void* data) {
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, vtx.size() * sizeof(vec3), &vtx[0], GL_DYNAMIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_DYNAMIC_DRAW);
 	}
-	void Draw(GPUProgram* prog, int type, vec3 color,float angle, vec3 rotatevec, vec3 transaltevec) {
-		if(vtx.size() == 0) return;
-		
-		mat4 M = scale(vec3(1.0f, 1.0f, 1.0f)) * rotate(angle,rotatevec) * translate(transaltevec);
-		mat4 MVP = M * camera->V() * camera->P();
-		
+	void BufferSubData(unsigned int vbo, size_t offset, size_t bytes, const void* data) {
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+	}
+	void InstanceData(unsigned int vao, unsigned int& instanceVbo, size_t bytes, const void* data) {
+		glBindVertexArray(vao);
+		if (instanceVbo == 0) {
+			glGenBuffers(1, &instanceVbo);
+			glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+			glVertexAttribDivisor(1, 1);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+		glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_DYNAMIC_DRAW);
+	}
+	void DeleteVertexArray(unsigned int vao, unsigned int vbo, unsigned int instanceVbo) {
+		if (instanceVbo != 0) glDeleteBuffers(1, &instanceVbo);
+		glDeleteBuffers(1, &vbo);
+		glDeleteVertexArrays(1, &vao);
+	}
+	void LineWidth(float w) { glLineWidth(w); }
+	void PointSize(float s) { glPointSize(s); }
+	void Uniforms(GPUProgram* prog, const mat4& MVP, vec3 color) {
+		program = prog;
 		prog->setUniform(MVP, "MVP");
 		prog->setUniform(color, "color");
-			glBindVertexArray(vao);
-			glDrawArrays(type, 0, (int)vtx.size());
+	}
+	//a még fel nem töltött (vao == 0) primitívek nem rajzolódnak
+	void DrawArrays(unsigned int vao, int type, int first, int count, const vec3* vtx) {
+		if (vao == 0) return;
+		glBindVertexArray(vao);
+		glDrawArrays(type, first, count);
+	}
+	void MultiDrawArrays(unsigned int vao, int type, const int* first, const int* count, int drawcount, int base, const vec3* vtx) {
+		if (vao == 0) return;
+		std::vector<int> shifted(first, first + drawcount);
+		for (int& f : shifted) f += base;
+		glBindVertexArray(vao);
+		glMultiDrawArrays(type, &shifted[0], count, drawcount);
+	}
+	void DrawArraysInstanced(unsigned int vao, int type, int first, int count, int instancecount, const vec3* vtx, const vec3* instances) {
+		if (vao == 0) return;
+		program->setUniform(true, "instanced");
+		glBindVertexArray(vao);
+		glDrawArraysInstanced(type, first, count, instancecount);
+		program->setUniform(false, "instanced");
+	}
+};
+//GL nélküli változat: a feltöltéseket (bájtokkal) és a rajzoló hívásokat számolja
+class CountingBackend : public RenderBackend {
+	unsigned int next = 0;
+public:
+	size_t allocations = 0, uploads = 0, uploaded = 0, instanceUploads = 0, draws = 0;
+	void GenVertexArray(unsigned int& vao, unsigned int& vbo) { vao = ++next; vbo = ++next; }
+	void BufferData(unsigned int vbo, size_t bytes, const void* data) {
+		allocations++;
+		if (data) { uploads++; uploaded += bytes; }
+	}
+	void BufferSubData(unsigned int vbo, size_t offset, size_t bytes, const void* data) { uploads++; uploaded += bytes; }
+	void InstanceData(unsigned int vao, unsigned int& instanceVbo, size_t bytes, const void* data) {
+		if (instanceVbo == 0) instanceVbo = ++next;
+		instanceUploads++;
+	}
+	void DeleteVertexArray(unsigned int vao, unsigned int vbo, unsigned int instanceVbo) {}
+	void LineWidth(float w) {}
+	void PointSize(float s) {}
+	void Uniforms(GPUProgram* prog, const mat4& MVP, vec3 color) {}
+	void DrawArrays(unsigned int vao, int type, int first, int count, const vec3* vtx) { if (vao != 0) draws++; }
+	void MultiDrawArrays(unsigned int vao, int type, const int* first, const int* count, int drawcount, int base, const vec3* vtx) {
+		if (vao != 0) draws++;
+	}
+	void DrawArraysInstanced(unsigned int vao, int type, int first, int count, int instancecount, const vec3* vtx, const vec3* instances) {
+		if (vao != 0) draws++;
+	}
+};
+//Szoftveres raszterizáló GPU nélküli futtatáshoz (CI, referenciaképek, sebességmérés), RenderBackend-ként.
+//A neki címzett rajzoló hívások csúcsainak CPU-s másolatát ugyanazzal az MVP-vel vetíti, mint az árnyaló, és a Finish
+//a képet csempékre bontva több szálon rajzolja ki. Egy csempén belül a primitívek a hívás sorrendjében kerülnek a képre,
+//így az eredmény nem függ a szálak számától. Puffereket nem kezel: ha primitívek tulajdonosa lenne, azok
+//feltöltetlenek (vao == 0) maradnak.
+class SoftwareRenderer : public RenderBackend {
+	//szakasz (2 pont), háromszög (3 pont) vagy pont (1 pont) képernyő-koordinátákban, befoglaló téglalappal
+	struct Element {
+		int count;
+		vec2 p[3];
+		float size; //vonalvastagság vagy pontméret pixelben
+		uint32_t color;
+		float xmin, ymin, xmax, ymax;
+	};
+	static const int tile = 32;
+	int width, height;
+	std::vector<uint32_t> pixels;
+	std::vector<Element> elements;
+	uint32_t background = 0;
+	float lineWidth = 1.0f, pointSize = 1.0f;
+	mat4 MVP;
+	uint32_t color = 0;
+
+	vec2 ToScreen(const mat4& MVP, const vec3& v) {
+		vec4 p = MVP * vec4(v.x, v.y, 0.0f, 1.0f);
+		return vec2((p.x / p.w + 1.0f) * 0.5f * width, (1.0f - p.y / p.w) * 0.5f * height);
+	}
+	void Add(int count, const vec2* p, float size, uint32_t color) {
+		Element e;
+		e.count = count;
+		e.size = size;
+		e.color = color;
+		e.xmin = e.xmax = p[0].x;
+		e.ymin = e.ymax = p[0].y;
+		for (int i = 0; i < count; i++) {
+			e.p[i] = p[i];
+			e.xmin = std::min(e.xmin, p[i].x); e.xmax = std::max(e.xmax, p[i].x);
+			e.ymin = std::min(e.ymin, p[i].y); e.ymax = std::max(e.ymax, p[i].y);
+		}
+		float pad = count == 3 ? 0.0f : std::max(size * 0.5f, 0.5f);
+		e.xmin -= pad; e.xmax += pad; e.ymin -= pad; e.ymax += pad;
+		if (e.xmax < 0 || e.ymax < 0 || e.xmin > width || e.ymin > height) return;
+		elements.push_back(e);
+	}
+	//A pixel középpontja az elemen belül van-e
+	static bool Covers(const Element& e, float x, float y) {
+		if (e.count == 1) {
+			float h = e.size * 0.5f;
+			return fabs(x - e.p[0].x) <= h && fabs(y - e.p[0].y) <= h;
+		}
+		if (e.count == 2) {
+			vec2 d = e.p[1] - e.p[0], w = vec2(x, y) - e.p[0];
+			float l2 = dot(d, d);
+			float t = l2 > 0.0f ? std::max(0.0f, std::min(dot(w, d) / l2, 1.0f)) : 0.0f;
+			vec2 q = w - d * t;
+			float h = std::max(e.size * 0.5f, 0.5f);
+			return dot(q, q) <= h * h;
+		}
+		float e0 = (e.p[1].x - e.p[0].x) * (y - e.p[0].y) - (e.p[1].y - e.p[0].y) * (x - e.p[0].x);
+		float e1 = (e.p[2].x - e.p[1].x) * (y - e.p[1].y) - (e.p[2].y - e.p[1].y) * (x - e.p[1].x);
+		float e2 = (e.p[0].x - e.p[2].x) * (y - e.p[2].y) - (e.p[0].y - e.p[2].y) * (x - e.p[2].x);
+		return (e0 >= 0 && e1 >= 0 && e2 >= 0) || (e0 <= 0 && e1 <= 0 && e2 <= 0);
+	}
+	void RasterTile(int tx, int ty) {
+		int x0 = tx * tile, y0 = ty * tile;
+		int x1 = std::min(x0 + tile, width), y1 = std::min(y0 + tile, height);
+		for (int y = y0; y < y1; y++) std::fill(&pixels[y * width + x0], &pixels[y * width + x1], background);
+		for (const Element& e : elements) {
+			int ex0 = std::max(x0, (int)floor(e.xmin)), ex1 = std::min(x1, (int)ceil(e.xmax) + 1);
+			int ey0 = std::max(y0, (int)floor(e.ymin)), ey1 = std::min(y1, (int)ceil(e.ymax) + 1);
+			for (int y = ey0; y < ey1; y++) {
+				for (int x = ex0; x < ex1; x++) {
+					if (Covers(e, x + 0.5f, y + 0.5f)) pixels[y * width + x] = e.color;
+				}
+			}
+		}
+	}
+	static uint32_t Pack(vec3 color) {
+		auto channel = [](float c) { return (uint32_t)(std::max(0.0f, std::min(c, 1.0f)) * 255.0f + 0.5f); };
+		return channel(color.x) << 16 | channel(color.y) << 8 | channel(color.z);
+	}
+	//Egy glDrawArrays megfelelője: a primitívet elemi szakaszokra, háromszögekre, pontokra bontjuk
+	void Submit(int type, const vec3* vtx, size_t n, const mat4& M) {
+		uint32_t c = color;
+		std::vector<vec2> p(n);
+		for (size_t i = 0; i < n; i++) p[i] = ToScreen(M, vtx[i]);
+		if (type == GL_POINTS) for (size_t i = 0; i < n; i++) Add(1, &p[i], pointSize, c);
+		if (type == GL_LINES) for (size_t i = 0; i + 1 < n; i += 2) Add(2, &p[i], lineWidth, c);
+		if (type == GL_LINE_STRIP || type == GL_LINE_LOOP) for (size_t i = 0; i + 1 < n; i++) Add(2, &p[i], lineWidth, c);
+		if (type == GL_LINE_LOOP && n > 2) {
+			vec2 closing[2] = { p[n - 1], p[0] };
+			Add(2, closing, lineWidth, c);
+		}
+		if (type == GL_TRIANGLE_FAN) {
+			for (size_t i = 1; i + 1 < n; i++) {
+				vec2 triangle[3] = { p[0], p[i], p[i + 1] };
+				Add(3, triangle, 0.0f, c);
+			}
+		}
+		if (type == GL_TRIANGLES) for (size_t i = 0; i + 2 < n; i += 3) Add(3, &p[i], 0.0f, c);
+	}
+public:
+	int threads = 0; //a Finish szálainak száma; 0: a magok száma
+	SoftwareRenderer(int w, int h) : width(w), height(h), pixels(w * h, 0) {}
+	int Width() { return width; }
+	int Height() { return height; }
+	const std::vector<uint32_t>& Pixels() { return pixels; }
+	void GenVertexArray(unsigned int& vao, unsigned int& vbo) { vao = vbo = 0; }
+	void BufferData(unsigned int vbo, size_t bytes, const void* data) {}
+	void BufferSubData(unsigned int vbo, size_t offset, size_t bytes, const void* data) {}
+	void InstanceData(unsigned int vao, unsigned int& instanceVbo, size_t bytes, const void* data) {}
+	void DeleteVertexArray(unsigned int vao, unsigned int vbo, unsigned int instanceVbo) {}
+	void LineWidth(float w) { lineWidth = w; }
+	void PointSize(float s) { pointSize = s; }
+	void Uniforms(GPUProgram* prog, const mat4& nMVP, vec3 ncolor) { MVP = nMVP; color = Pack(ncolor); }
+	void DrawArrays(unsigned int vao, int type, int first, int count, const vec3* vtx) { Submit(type, vtx + first, count, MVP); }
+	void MultiDrawArrays(unsigned int vao, int type, const int* first, const int* count, int drawcount, int base, const vec3* vtx) {
+		for (int k = 0; k < drawcount; k++) Submit(type, vtx + first[k], count[k], MVP);
+	}
+	//az árnyaló példányonkénti forgatása és eltolása a modell-transzformációban
+	void DrawArraysInstanced(unsigned int vao, int type, int first, int count, int instancecount, const vec3* vtx, const vec3* instances) {
+		for (int i = 0; i < instancecount; i++) {
+			mat4 M = translate(vec3(instances[i].x, instances[i].y, 0.0f)) * rotate(instances[i].z, vec3(0.0f, 0.0f, 1.0f));
+			Submit(type, vtx + first, count, MVP * M);
+		}
+	}
+	//Új képkocka: a háttérszínt a Finish festi fel csempénként
+	void Clear(vec3 color) {
+		background = Pack(color);
+		elements.clear();
+	}
+	//A képkocka kiraszterizálása: a csempéket a szálak egy közös számlálóról veszik el
+	void Finish() {
+		int tilesX = (width + tile - 1) / tile, tilesY = (height + tile - 1) / tile;
+		std::atomic<int> next(0);
+		auto worker = [&]() {
+			for (int i = next++; i < tilesX * tilesY; i = next++) RasterTile(i % tilesX, i / tilesX);
+		};
+		int nthreads = std::max(1, std::min(threads > 0 ? threads : (int)std::thread::hardware_concurrency(), tilesX * tilesY));
+		std::vector<std::thread> workers;
+		for (int i = 1; i < nthreads; i++) workers.push_back(std::thread(worker));
+		worker();
+		for (auto& w : workers) w.join();
+		elements.clear();
+	}
+	//Bináris PPM (P6) a megadott folyamba, így a képsorozat fájlokba vagy csőbe (pl. videókódolónak) is mehet
+	bool WritePPM(FILE* out) {
+		fprintf(out, "P6\n%d %d\n255\n", width, height);
+		std::vector<unsigned char> row(width * 3);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				uint32_t c = pixels[y * width + x];
+				row[x * 3] = c >> 16 & 255; row[x * 3 + 1] = c >> 8 & 255; row[x * 3 + 2] = c & 255;
+			}
+			if (fwrite(&row[0], 1, row.size(), out) != row.size()) return false;
+		}
+		return true;
+	}
+	bool WritePPM(const char* filename) {
+		FILE* out = fopen(filename, "wb");
+		if (!out) return false;
+		bool ok = WritePPM(out);
+		return fclose(out) == 0 && ok;
+	}
+};
+
+GLBackend glBackend;
+//Az ezután létrehozott primitívek pufferei ezen jönnek létre (tesztben lecserélhető, pl. CountingBackend-re).
+//A rajzolás célját minden Draw paraméterben kapja, így egy képkocka a GL helyett a SoftwareRenderer-be is mehet.
+RenderBackend* backend = &glBackend;
+
+class Primitive2D {
+	unsigned int vao = 0, vbo = 0;	
+	unsigned int instanceVbo = 0;
+	bool dirty = true; //a csúcsok a legutóbbi Load óta változtak
+	std::vector<vec3> instances; //a példányadatok CPU-s másolata (a szoftveres raszterizálónak)
+	bool instancesDirty = false; //az instances a legutóbbi feltöltés óta változott
+	RenderBackend* resources = backend; //a pufferek tulajdonosa; csak a neki szóló rajzolás tölt fel
+protected:
+	std::vector<vec3> vtx;	
+public:
+	Primitive2D() {}
+	std::vector<vec3>& Vtx() { return vtx; }
+	//A Vtx() módosítása után jelezni kell, különben a Load nem tölti fel újra
+	void MarkDirty() { dirty = true; }
+	//A GL objektumok az első feltöltéskor jönnek létre, így GL környezet nélkül is létrehozható;
+	//GPU-s puffer nélküli backendnél (vao == 0 marad) a csúcsok feltöltetlenek maradnak
+	void Load() {
+		if (!dirty || vtx.empty()) return;
+		if (vao == 0) resources->GenVertexArray(vao, vbo);
+		if (vao == 0) return;
+		resources->BufferData(vbo, vtx.size() * sizeof(vec3), &vtx[0]);
+		dirty = false;
+	}
+	//Példányadatok (x, y eltolás, z szög) a DrawInstanced-hez; a csúcsok nem mennek fel újra, a példányadatok
+	//is csak a pufferek tulajdonosának szóló következő DrawInstanced-nél
+	void LoadInstances(const std::vector<vec3>& ninstances) {
+		instances = ninstances;
+		instancesDirty = true;
+	}
+	void Draw(RenderBackend* target, GPUProgram* prog, int type, vec3 color,float angle, vec3 rotatevec, vec3 transaltevec) {
+		if(vtx.size() == 0) return;
 		
+		mat4 M = translate(transaltevec) * rotate(angle, rotatevec);
+		target->Uniforms(prog, camera->VP() * M, color);
+		target->DrawArrays(vao, type, 0, (int)vtx.size(), &vtx[0]);
+	}
+	//Az összes betöltött példány egy hívással
+	void DrawInstanced(RenderBackend* target, GPUProgram* prog, int type, vec3 color) {
+		if (vtx.size() == 0 || instances.empty()) return;
+		if (target == resources && instancesDirty && vao != 0) {
+			resources->InstanceData(vao, instanceVbo, instances.size() * sizeof(vec3), &instances[0]);
+			instancesDirty = false;
+		}
+		target->Uniforms(prog, camera->VP(), color);
+		target->DrawArraysInstanced(vao, type, 0, (int)vtx.size(), (int)instances.size(), &vtx[0], &instances[0]);
 	}
   ~Primitive2D() {
-		glDeleteBuffers(1, &vbo);
-		glDeleteVertexArrays(1, &vao);
+		if (vao != 0) resources->DeleteVertexArray(vao, vbo, instanceVbo);
 	}
 };
 
+//Megtartott rajzlista: több, azonos programmal rajzolt Primitive2D csúcsai egy közös pufferben, egymás után.
+//Csak szerkesztés (Invalidate) után tölt fel, akkor is a meglévő pufferbe, ha belefér, és csak a puffer
+//tulajdonosának szóló rajzolásnál; a primitívenkénti tartományok egy MultiDrawArrays hívással mennek ki.
+class RenderList {
+	std::vector<Primitive2D*> primitives;
+	std::vector<size_t> offsets; //a primitívek első csúcsa a közös pufferben
+	unsigned int vao = 0, vbo = 0;
+	size_t capacity = 0; //a pufferben lefoglalt csúcsok száma
+	bool dirty = true;
+	RenderBackend* resources = backend; //a puffer tulajdonosa
+
+	int Index(Primitive2D* primitive) {
+		return (int)(std::find(primitives.begin(), primitives.end(), primitive) - primitives.begin());
+	}
+public:
+	void Add(Primitive2D* primitive) { primitives.push_back(primitive); offsets.push_back(0); dirty = true; }
+	void Invalidate() { dirty = true; }
+	void Sync() {
+		if (!dirty) return;
+		size_t total = 0;
+		for (size_t i = 0; i < primitives.size(); i++) { offsets[i] = total; total += primitives[i]->Vtx().size(); }
+		if (total == 0) return;
+		if (vao == 0) resources->GenVertexArray(vao, vbo);
+		if (vao == 0) return;
+		if (total > capacity) {
+			capacity = std::max(total, capacity * 2);
+			resources->BufferData(vbo, capacity * sizeof(vec3), NULL);
+		}
+		for (size_t i = 0; i < primitives.size(); i++) {
+			std::vector<vec3>& vtx = primitives[i]->Vtx();
+			if (!vtx.empty()) resources->BufferSubData(vbo, offsets[i] * sizeof(vec3), vtx.size() * sizeof(vec3), &vtx[0]);
+		}
+		dirty = false;
+	}
+	//A primitív [first[k], first[k] + count[k]) tartományai egy hívással, modell-transzformáció nélkül
+	void Draw(RenderBackend* target, GPUProgram* prog, Primitive2D* primitive, int type, vec3 color, const std::vector<int>& first, const std::vector<int>& count) {
+		if (first.empty()) return;
+		if (target == resources) Sync();
+		target->Uniforms(prog, camera->VP(), color);
+		target->MultiDrawArrays(vao, type, &first[0], &count[0], (int)first.size(), (int)offsets[Index(primitive)], &primitive->Vtx()[0]);
+	}
+	~RenderList() {
+		if (vao != 0) resources->DeleteVertexArray(vao, vbo, 0);
+	}
+};
+
+//A pálya egy pontja a paraméter szerinti első és második deriválttal
+struct SplineSample {
+	vec3 r, rt, rtt;
+};
+
 class Spline {
+	//Egy szakasz Hermite-együtthatói: r(u) = ((a3*u + a2)*u + a1)*u + a0, u = (t - t0) / dt
+	struct Segment {
+		vec3 a0, a1, a2, a3;
+		float t0, dt;
+	};
+	std::vector<Segment> segments;
+	int lastSegment = 0; //az utoljára talált szakasz, monoton t-re a következő keresés O(1)
+
+	//Az i. szakasz együtthatói a Catmull-Rom érintőkkel
+	Segment MakeSegment(size_t i) {
+		std::vector<vec3>& cps = ControlPoints.Vtx();
+		vec3 p0 = i > 0 ? cps[i - 1] : cps[i];
+		vec3 p1 = cps[i];
+		vec3 p2 = cps[i + 1];
+		vec3 p3 = i + 2 < cps.size() ? cps[i + 2] : cps[i + 1];
+		vec3 v0 = (p2 - p0) * 0.5f;
+		vec3 v1 = (p3 - p1) * 0.5f;
+		Segment s;
+		s.t0 = ts[i];
+		s.dt = ts[i + 1] - ts[i];
+		s.a0 = p1;
+		s.a1 = v0 * s.dt;
+		s.a2 = (p2 - p1) * 3.0f - (v1 + v0 * 2.0f) * s.dt;
+		s.a3 = (p1 - p2) * 2.0f + (v1 + v0) * s.dt;
+		return s;
+	}
+	//Ívhossz-táblázat: szakaszonként arcSteps részintervallum végpontjaiban az összegzett ívhossz
+	static const int arcSteps = 8;
+	std::vector<float> arcS;
+	size_t arcValid = 0; //ennyi szakasz táblázatrésze érvényes
+
+	//|dr/du| az u helyen
+	float Speed(const Segment& s, float u) { return length((3.0f * s.a3 * u + 2.0f * s.a2) * u + s.a1); }
+	//Ívhossz [ua, ub]-n 5 pontos Gauss-Legendre kvadratúrával
+	float ArcIntegral(const Segment& s, float ua, float ub) {
+		static const float x[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+		static const float w[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+		float half = 0.5f * (ub - ua), mid = 0.5f * (ua + ub), sum = 0.0f;
+		for (int k = 0; k < 5; k++) sum += w[k] * Speed(s, mid + half * x[k]);
+		return sum * half;
+	}
+	//A táblázat újraszámolása az első érvénytelen szakasztól
+	void UpdateArcTable() {
+		if (arcValid == segments.size() && arcS.size() == segments.size() * arcSteps + 1) return;
+		arcS.resize(segments.size() * arcSteps + 1);
+		arcS[0] = 0.0f;
+		for (size_t i = arcValid; i < segments.size(); i++) {
+			for (int k = 0; k < arcSteps; k++) {
+				size_t j = i * arcSteps + k;
+				arcS[j + 1] = arcS[j] + ArcIntegral(segments[i], float(k) / arcSteps, float(k + 1) / arcSteps);
+			}
+		}
+		arcValid = segments.size();
+	}
+	//Adaptív felbontás: szakaszonként az első pont indexe a SplinePoints-ban
+	std::vector<size_t> tessStart;
+	std::vector<vec3> tessMin, tessMax; //szakaszonként a pontok befoglaló téglalapja a láthatósághoz
+	size_t tessValid = 0; //ennyi szakasz pontjai érvényesek
+	float tolerance = 0.5f; //megengedett eltérés a húrtól, pixelben
+	float tessScale = 0.0f; //a felbontáskor érvényes világ/pixel arány; nagyítás után újra kell bontani
+
+	vec3 SegmentPoint(const Segment& s, float u) { return ((s.a3 * u + s.a2) * u + s.a1) * u + s.a0; }
+	//[u0, u1] felezése, amíg a felezőpont a húrtól tol-nál messzebb van; a belső pontokat (u1 nélkül) out-ba teszi
+	void Subdivide(const Segment& s, float u0, const vec3& p0, float u1, const vec3& p1, float tol, int depth, std::vector<vec3>& out) {
+		float um = 0.5f * (u0 + u1);
+		vec3 pm = SegmentPoint(s, um);
+		vec3 chord = p1 - p0;
+		float len = length(chord);
+		vec3 off = pm - p0;
+		float dist = len > 0.0f ? fabs(chord.x * off.y - chord.y * off.x) / len : length(off);
+		//az első felezés mindig megtörténik, hogy a szakasz közepén visszaforduló ív se maradjon ki
+		if (depth < 16 && (depth == 0 || dist > tol)) {
+			Subdivide(s, u0, p0, um, pm, tol, depth + 1, out);
+			out.push_back(pm);
+			Subdivide(s, um, pm, u1, p1, tol, depth + 1, out);
+		}
+	}
 public:
 	Primitive2D ControlPoints;
 	Primitive2D SplinePoints;
+	RenderList batch; //a görbe és a kontrollpontok közös puffere
 	std::vector<float> ts;
-	Spline() : ControlPoints(), SplinePoints() {}
+	Spline() : ControlPoints(), SplinePoints() {
+		batch.Add(&SplinePoints);
+		batch.Add(&ControlPoints);
+	}
 	void AddControlPoint(vec3 mouse) {
 		float ti = ControlPoints.Vtx().size(); 
 		ControlPoints.Vtx().push_back(mouse); 
 		ts.push_back(ti); 
-		SplinePoints.Vtx().clear(); 
+		batch.Invalidate();
+		//az új pont az utolsó két szakaszt érinti, csak ezeket számoljuk újra
+		size_t n = ControlPoints.Vtx().size();
+		if (n < 2) return;
+		segments.resize(n - 1);
+		for (size_t i = (n >= 3 ? n - 3 : 0); i < n - 1; i++) segments[i] = MakeSegment(i);
+		arcValid = std::min(arcValid, n >= 3 ? n - 3 : 0);
+		tessValid = std::min(tessValid, n >= 3 ? n - 3 : 0);
 	}
-	
-	vec3 Hermite(vec3 p0, vec3 v0, float t0, vec3 p1, vec3 v1, float t1, float t) {
-		float dt = t1 - t0;
-		t = (t - t0) / dt;
-		vec3 a0 = p0;
-		vec3 a1 = v0 * dt;
-		vec3 a2 = (p1 - p0) * 3.0f - (v1 + v0 * 2.0f) * dt;
-		vec3 a3 = (p0 - p1) * 2.0f + (v1 + v0) * dt;
-		return ((a3 * t + a2) * t + a1) * t + a0;
-	}
-	vec3 Hermitet(vec3 p0, vec3 v0, float t0, vec3 p1, vec3 v1, float t1, float t) {
-		float dt = t1 - t0;
-		t = (t - t0) / dt;
-		vec3 a0 = p0;
-		vec3 a1 = v0 * dt;
-		vec3 a2 = (p1 - p0) * 3.0f - (v1 + v0 * 2.0f) * dt;
-		vec3 a3 = (p0 - p1) * 2.0f + (v1 + v0) * dt;
-		return (3.0f * a3 * t + 2.0f * a2) * t + a1;
-	}
-	vec3 Hermitett(vec3 p0, vec3 v0, float t0, vec3 p1, vec3 v1, float t1, float t) {
-		float dt = t1 - t0;
-		t = (t - t0) / dt;
-		vec3 a0 = p0;
-		vec3 a1 = v0 * dt;
-		vec3 a2 = (p1 - p0) * 3.0f - (v1 + v0 * 2.0f) * dt;
-		vec3 a3 = (p0 - p1) * 2.0f + (v1 + v0) * dt;
-		return 6.0f * a3 * t + 2.0f * a2;
+	//A görbe képernyőn megengedett eltérése a húroktól (pixel); a teljes görbét újra kell bontani
+	void SetTolerance(float pixels) { tolerance = pixels; tessValid = 0; }
+	//A pálya teljes hossza
+	float Length() {
+		UpdateArcTable();
+		return arcS.empty() ? 0.0f : arcS.back();
+	}
+	//Ívhossz a pálya elejétől t-ig
+	float ArcLength(float t) {
+		int i = FindSegment(t);
+		if (i < 0) return t < ts.front() ? 0.0f : Length();
+		UpdateArcTable();
+		const Segment& s = segments[i];
+		float u = (t - s.t0) / s.dt;
+		int k = std::min((int)(u * arcSteps), arcSteps - 1);
+		return arcS[i * arcSteps + k] + ArcIntegral(s, float(k) / arcSteps, u);
+	}
+	//Az s ívhosszhoz tartozó paraméter: bináris keresés a táblázatban, majd Newton-lépések a részintervallumon belül.
+	//A lépések a gyököt közrefogó [lo, hi] intervallumban maradnak, onnan kilépő lépés helyett felezünk: ahol a sebesség
+	//a részintervallumon belül erősen változik (éles kanyar), a sima Newton-iteráció nem konvergálna.
+	float ParamAt(float s) {
+		UpdateArcTable();
+		if (arcS.size() < 2) return ts.empty() ? 0.0f : ts.front();
+		s = std::max(0.0f, std::min(s, arcS.back()));
+		int j = (int)(std::upper_bound(arcS.begin(), arcS.end(), s) - arcS.begin()) - 1;
+		j = std::max(0, std::min(j, (int)arcS.size() - 2));
+		const Segment& seg = segments[j / arcSteps];
+		float ua = float(j % arcSteps) / arcSteps, ub = float(j % arcSteps + 1) / arcSteps;
+		float ds = arcS[j + 1] - arcS[j];
+		float u = ds > 0.0f ? ua + (s - arcS[j]) / ds * (ub - ua) : ua;
+		float lo = ua, hi = ub;
+		for (int it = 0; it < 12; it++) {
+			float f = arcS[j] + ArcIntegral(seg, ua, u) - s;
+			if (f > 0.0f) hi = u; else lo = u;
+			float speed = Speed(seg, u);
+			float next = speed > 0.0f ? u - f / speed : 0.5f * (lo + hi);
+			if (!(next >= lo && next <= hi)) next = 0.5f * (lo + hi);
+			bool done = fabs(next - u) <= 1e-6f * (ub - ua);
+			u = next;
+			if (done) break;
+		}
+		return seg.t0 + u * seg.dt;
 	}
 
-	vec3 r(float t) {
-		if (ControlPoints.Vtx().size() < 2) return ControlPoints.Vtx().back(); 
-
-		for (unsigned int i = 0; i < ControlPoints.Vtx().size() - 1; i++) {
-			if (ts[i] <= t && t <= ts[i + 1]) {
-				vec3  p0 = ControlPoints.Vtx()[i];
-				if (i > 0) p0 =  ControlPoints.Vtx()[i - 1] ;
-				vec3 p1 = ControlPoints.Vtx()[i]; 
-				vec3 p2 = ControlPoints.Vtx()[i+1];  
-				vec3  p3 = ControlPoints.Vtx()[i+1];
-				if(i < ControlPoints.Vtx().size() - 2) p3 = ControlPoints.Vtx()[i + 2];
-				vec3 v0 = (p2 - p0) * 0.5f; 
-				vec3 v1 = (p3 - p1) * 0.5f; 
-				return Hermite(p1, v0, ts[i], p2, v1, ts[i + 1], t);
-			}
+	//A t-t tartalmazó szakasz indexe (határon a korábbi szakasz, mint a lineáris keresésnél), -1 ha t a pályán kívül esik
+	//A hint a keresés kiindulópontja; több szál mindegyike a sajátját adja, így a keresés nem ír közös állapotot
+	int FindSegment(float t, int& hint) {
+		if (segments.empty() || !(t >= ts.front() && t <= ts.back())) return -1;
+		int i = std::min(std::max(hint, 0), (int)segments.size() - 1);
+		for (int k = 0; k < 2 && i < (int)segments.size(); k++, i++) {
+			if (ts[i] <= t && t <= ts[i + 1] && (i == 0 || t > ts[i])) return hint = i;
 		}
-		return ControlPoints.Vtx().back(); 
+		i = (int)(std::lower_bound(ts.begin(), ts.end(), t) - ts.begin()) - 1;
+		return hint = std::max(i, 0);
+	}
+	int FindSegment(float t) { return FindSegment(t, lastSegment); }
+	vec3 r(float t) {
+		int i = FindSegment(t);
+		if (i < 0) return ControlPoints.Vtx().back();
+		const Segment& s = segments[i];
+		float u = (t - s.t0) / s.dt;
+		return ((s.a3 * u + s.a2) * u + s.a1) * u + s.a0;
 	}
 	vec3 rt(float t) {
-		if (ControlPoints.Vtx().size() < 2) return ControlPoints.Vtx().back();
-
-		for (unsigned int i = 0; i < ControlPoints.Vtx().size() - 1; i++) {
-			if (ts[i] <= t && t <= ts[i + 1]) {
-				vec3  p0 = ControlPoints.Vtx()[i];
-				if (i > 0) p0 = ControlPoints.Vtx()[i - 1];
-				vec3 p1 = ControlPoints.Vtx()[i];
-				vec3 p2 = ControlPoints.Vtx()[i + 1];
-				vec3  p3 = ControlPoints.Vtx()[i + 1];
-				if (i < ControlPoints.Vtx().size() - 2) p3 = ControlPoints.Vtx()[i + 2];
-				vec3 v0 = (p2 - p0) * 0.5f;
-				vec3 v1 = (p3 - p1) * 0.5f;
-				return Hermitet(p1, v0, ts[i], p2, v1, ts[i + 1], t);
-			}
-		}
-		return ControlPoints.Vtx().back();
+		int i = FindSegment(t);
+		if (i < 0) return ControlPoints.Vtx().back();
+		const Segment& s = segments[i];
+		float u = (t - s.t0) / s.dt;
+		return (3.0f * s.a3 * u + 2.0f * s.a2) * u + s.a1;
 	}
 	vec3 rtt(float t) {
-		if (ControlPoints.Vtx().size() < 2) return ControlPoints.Vtx().back();
-
-		for (unsigned int i = 0; i < ControlPoints.Vtx().size() - 1; i++) {
-			if (ts[i] <= t && t <= ts[i + 1]) {
-				vec3  p0 = ControlPoints.Vtx()[i];
-				if (i > 0) p0 = ControlPoints.Vtx()[i - 1];
-				vec3 p1 = ControlPoints.Vtx()[i];
-				vec3 p2 = ControlPoints.Vtx()[i + 1];
-				vec3  p3 = ControlPoints.Vtx()[i + 1];
-				if (i < ControlPoints.Vtx().size() - 2) p3 = ControlPoints.Vtx()[i + 2];
-				vec3 v0 = (p2 - p0) * 0.5f;
-				vec3 v1 = (p3 - p1) * 0.5f;
-				return Hermitett(p1, v0, ts[i], p2, v1, ts[i + 1], t);
+		int i = FindSegment(t);
+		if (i < 0) return ControlPoints.Vtx().back();
+		const Segment& s = segments[i];
+		float u = (t - s.t0) / s.dt;
+		return 6.0f * s.a3 * u + 2.0f * s.a2;
+	}
+	//r, rt és rtt egyetlen szakaszkereséssel
+	SplineSample Eval(float t) {
+		SplineSample sample;
+		int i = FindSegment(t);
+		if (i < 0) { sample.r = sample.rt = sample.rtt = ControlPoints.Vtx().back(); return sample; }
+		const Segment& s = segments[i];
+		float u = (t - s.t0) / s.dt;
+		sample.r = ((s.a3 * u + s.a2) * u + s.a1) * u + s.a0;
+		sample.rt = (3.0f * s.a3 * u + 2.0f * s.a2) * u + s.a1;
+		sample.rtt = 6.0f * s.a3 * u + 2.0f * s.a2;
+		return sample;
+	}
+	//Kötegelt kiértékelés: mintánként csak a szakaszkeresés, a polinomok komponensenként
+	//folytonos tömbökön (SoA) futnak, ezt a ciklust a fordító a minták mentén vektorizálja
+	//A hint-tel (lásd FindSegment) több szálból is hívható, ha az ívhossz-táblázat már kész (Length())
+	void Eval(const float* t, int n, SplineSample* out, int* hint = nullptr) {
+		int& h = hint ? *hint : lastSegment;
+		const int chunk = 64;
+		float u[chunk], a[4][3][chunk], res[3][3][chunk];
+		for (int first = 0; first < n; first += chunk) {
+			int m = std::min(chunk, n - first);
+			for (int k = 0; k < m; k++) {
+				int i = FindSegment(t[first + k], h);
+				//pályán kívül: u = 0 mellett r = rt = rtt = utolsó kontrollpont
+				vec3 c[4];
+				if (i < 0) {
+					vec3 back = ControlPoints.Vtx().back();
+					u[k] = 0.0f;
+					c[0] = back; c[1] = back; c[2] = back * 0.5f; c[3] = vec3(0.0f, 0.0f, 0.0f);
+				}
+				else {
+					const Segment& s = segments[i];
+					u[k] = (t[first + k] - s.t0) / s.dt;
+					c[0] = s.a0; c[1] = s.a1; c[2] = s.a2; c[3] = s.a3;
+				}
+				for (int j = 0; j < 4; j++) { a[j][0][k] = c[j].x; a[j][1][k] = c[j].y; a[j][2][k] = c[j].z; }
+			}
+			for (int d = 0; d < 3; d++) {
+				const float *a0 = a[0][d], *a1 = a[1][d], *a2 = a[2][d], *a3 = a[3][d];
+				for (int k = 0; k < m; k++) {
+					res[0][d][k] = ((a3[k] * u[k] + a2[k]) * u[k] + a1[k]) * u[k] + a0[k];
+					res[1][d][k] = (3.0f * a3[k] * u[k] + 2.0f * a2[k]) * u[k] + a1[k];
+					res[2][d][k] = 6.0f * a3[k] * u[k] + 2.0f * a2[k];
+				}
+			}
+			for (int k = 0; k < m; k++) {
+				out[first + k].r = vec3(res[0][0][k], res[0][1][k], res[0][2][k]);
+				out[first + k].rt = vec3(res[1][0][k], res[1][1][k], res[1][2][k]);
+				out[first + k].rtt = vec3(res[2][0][k], res[2][1][k], res[2][2][k]);
 			}
 		}
-		return ControlPoints.Vtx().back();
 	}
-	
-	
-	
-	
-	
-	
-	
-	
-	
-	
+
+	//Görbületfüggő felbontás: szakaszonként addig felezünk, amíg a görbe a húrtól a tűrésen belül marad.
+	//Csak a legutóbbi AddSpline óta megváltozott szakaszokat bontja újra, a korábbi pontok megmaradnak.
 	void AddSpline() {
 		if (ControlPoints.Vtx().size() < 2) return;
-
-		for (int i = 0; i <= 100; i++) {
-			float t = ts[0] + (ts[ts.size() - 1] - ts[0]) * (i / 100.0f);
-			SplinePoints.Vtx().push_back(r(t));
+		float worldPerPixel = fabs(camera->ScreenToWorld(vec3(1.0f, 0.0f, 0.0f)).x - camera->ScreenToWorld(vec3(0.0f, 0.0f, 0.0f)).x);
+		if (worldPerPixel != tessScale) { tessValid = 0; tessScale = worldPerPixel; }
+		if (tessValid == segments.size()) return;
+		float tol = tolerance * worldPerPixel;
+		std::vector<vec3>& vtx = SplinePoints.Vtx();
+		tessStart.resize(segments.size());
+		tessMin.resize(segments.size());
+		tessMax.resize(segments.size());
+		vtx.resize(tessValid > 0 ? tessStart[tessValid] : 0);
+		for (size_t i = tessValid; i < segments.size(); i++) {
+			tessStart[i] = vtx.size();
+			vec3 p0 = SegmentPoint(segments[i], 0.0f), p1 = SegmentPoint(segments[i], 1.0f);
+			vtx.push_back(p0);
+			Subdivide(segments[i], 0.0f, p0, 1.0f, p1, tol, 0, vtx);
+			vtx.push_back(p1);
+			vec3 bmin = p1, bmax = p1;
+			for (size_t j = tessStart[i]; j < vtx.size(); j++) {
+				bmin = vec3(std::min(bmin.x, vtx[j].x), std::min(bmin.y, vtx[j].y), 0.0f);
+				bmax = vec3(std::max(bmax.x, vtx[j].x), std::max(bmax.y, vtx[j].y), 0.0f);
+			}
+			//a görbe legfeljebb tol-ra van a töröttvonaltól
+			tessMin[i] = bmin - vec3(tol, tol, 0.0f);
+			tessMax[i] = bmax + vec3(tol, tol, 0.0f);
+			vtx.pop_back();
 		}
+		vtx.push_back(ControlPoints.Vtx().back());
+		tessValid = segments.size();
+		batch.Invalidate();
 	}
 	
-	void Draw(GPUProgram* prog) {
+	void Draw(RenderBackend* target, GPUProgram* prog) {
 		if (ControlPoints.Vtx().size() == 0) return;
 		if (ControlPoints.Vtx().size() > 1) {
-			SplinePoints.Load();
-			glLineWidth(3.0f);
-			SplinePoints.Draw(prog, GL_LINE_STRIP, vec3(1.0f, 1.0f, 0.0f), 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 0.0f));
+			target->LineWidth(3.0f);
+			//csak a látható szakaszok; az egymást követő láthatók egy töröttvonalat adnak, ezek egy hívásban mennek ki
+			std::vector<int> first, count;
+			size_t n = std::min(tessValid, segments.size());
+			for (size_t i = 0; i < n; i++) {
+				if (!camera->Visible(tessMin[i], tessMax[i])) continue;
+				size_t j = i;
+				while (j + 1 < n && camera->Visible(tessMin[j + 1], tessMax[j + 1])) j++;
+				size_t last = j + 1 < tessStart.size() ? tessStart[j + 1] : SplinePoints.Vtx().size() - 1;
+				first.push_back((int)tessStart[i]);
+				count.push_back((int)(last - tessStart[i] + 1));
+				i = j;
+			}
+			batch.Draw(target, prog, &SplinePoints, GL_LINE_STRIP, vec3(1.0f, 1.0f, 0.0f), first, count);
 		}
-		glPointSize(10.0f);
-		ControlPoints.Load();
-		ControlPoints.Draw(prog, GL_POINTS, vec3(1.0f, 0.0f, 0.0f), 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 0.0f));
-	
+		target->PointSize(10.0f);
+		batch.Draw(target, prog, &ControlPoints, GL_POINTS, vec3(1.0f, 0.0f, 0.0f), std::vector<int>(1, 0), std::vector<int>(1, (int)ControlPoints.Vtx().size()));
 	}
 
 
 };
+//A kerék geometriája a saját középpontja körül, egyszer felépítve és feltöltve.
+//Rajzoláskor a helyet és az elfordulást a modell-transzformáció (vagy a példányadat) adja,
+//így mozgás közben nincs csúcsfeltöltés, és sok kerék osztozhat ugyanazon a hálón.
+class WheelMesh {
+	Primitive2D body;
+	Primitive2D outline;
+	Primitive2D spokes;
+public:
+	WheelMesh() {
+		for (int i = 0; i < 32; i++) {
+			float theta = 2.0f * M_PI * float(i) / 32.0f;
+			outline.Vtx().push_back(vec3(2.0f * cos(theta), 2.0f * sin(theta), 0));
+			body.Vtx().push_back(vec3(2.0f * cos(theta), 2.0f * sin(theta), 0));
+		}
+		for (int i = 0; i < 4; i++) {
+			float theta = 2.0f * M_PI * float(i) / 4.0f;
+			spokes.Vtx().push_back(vec3(0, 0, 0));
+			spokes.Vtx().push_back(vec3(2.0f * cos(theta), 2.0f * sin(theta), 0));
+		}
+		body.Load();
+		outline.Load();
+		spokes.Load();
+	}
+	//Egy kerék a center pontban, elfordulas szöggel (óramutató járása szerint)
+	void Draw(RenderBackend* target, GPUProgram* prog, vec3 center, float elfordulas) {
+		target->LineWidth(3.0f);
+		body.Draw(target, prog, GL_TRIANGLE_FAN, vec3(1.0f, 1.0f, 1.0f), -elfordulas, vec3(0.0f, 0.0f, 1.0f), center);
+		outline.Draw(target, prog, GL_LINE_LOOP, vec3(1.0f, 1.0f, 1.0f), -elfordulas, vec3(0.0f, 0.0f, 1.0f), center);
+		spokes.Draw(target, prog, GL_LINES, vec3(1.0f, 1.0f, 1.0f), -elfordulas, vec3(0.0f, 0.0f, 1.0f), center);
+	}
+	//Sok kerék egy-egy hívással; példányonként (x, y, -elfordulas)
+	void DrawInstanced(RenderBackend* target, GPUProgram* prog, const std::vector<vec3>& instances) {
+		body.LoadInstances(instances);
+		outline.LoadInstances(instances);
+		spokes.LoadInstances(instances);
+		target->LineWidth(3.0f);
+		body.DrawInstanced(target, prog, GL_TRIANGLE_FAN, vec3(1.0f, 1.0f, 1.0f));
+		outline.DrawInstanced(target, prog, GL_LINE_LOOP, vec3(1.0f, 1.0f, 1.0f));
+		spokes.DrawInstanced(target, prog, GL_LINES, vec3(1.0f, 1.0f, 1.0f));
+	}
+};
+
+//Rögzített fizikai lépésköz: a szimuláció nem függ a képkockák idejétől, ugyanannyi lépés mindig ugyanazt az eredményt adja
+const float physicsStep = 1.0f / 240.0f;
+//Egy képkockán belül legfeljebb ennyi lépés, hogy egy hosszú akadás után ne fusson el a szimuláció
+const int maxStepsPerFrame = 32;
+
+enum Integrator { SEMI_IMPLICIT_EULER, RK4 };
+
 class Gondola {
+	//Pályamenti gyorsulás az s ívhosszú pontban: a nehézségi gyorsulás érintő irányú vetülete
+	float Acceleration(float s) {
+		SplineSample sample = track->Eval(track->ParamAt(s));
+		return -g * sample.rt.y / length(sample.rt);
+	}
+	//Egy lépés az (ívhossz, sebesség) állapoton
+	void Integrate(float h) {
+		if (integrator == SEMI_IMPLICIT_EULER) {
+			v += Acceleration(ivhossz) * h;
+			ivhossz += v * h;
+			return;
+		}
+		float s1 = ivhossz, v1 = v, a1 = Acceleration(s1);
+		float s2 = ivhossz + 0.5f * h * v1, v2 = v + 0.5f * h * a1, a2 = Acceleration(s2);
+		float s3 = ivhossz + 0.5f * h * v2, v3 = v + 0.5f * h * a2, a3 = Acceleration(s3);
+		float s4 = ivhossz + h * v3, v4 = v + h * a3, a4 = Acceleration(s4);
+		ivhossz += h / 6.0f * (v1 + 2.0f * v2 + 2.0f * v3 + v4);
+		v += h / 6.0f * (a1 + 2.0f * a2 + 2.0f * a3 + a4);
+	}
+	//Pálya menti helyzet, érintő, normális és a pálya által kifejtett (tömegegységre jutó) erő a jelenlegi ívhossznál
+	void UpdateFrame() {
+		tau = track->ParamAt(ivhossz);
+		SplineSample sample = track->Eval(tau);
+		float rtlen = length(sample.rt);
+		position = sample.r;
+		T = sample.rt / rtlen;
+		N.x = -T.y; N.y = T.x; N.z = 0.0f;
+		cposition = position + N * radius;
+		//előjeles görbület: pozitív, ha a pálya a kerék (N) felé fordul
+		float kappa = (sample.rt.x * sample.rtt.y - sample.rt.y * sample.rtt.x) / (rtlen * rtlen * rtlen);
+		gorbulet = N * kappa;
+		//a centripetális gyorsuláshoz szükséges erő és a gravitáció normális irányú részének különbsége
+		K = N * (v * v * kappa + g * N.y);
+	}
 public:
-	int State; // 0 = idle, 1 = mozgs, 2 = lereplt
-	Primitive2D wheelBody;
-	Primitive2D wheelOutline;
-	Primitive2D spokes;
+	int State; // 0 = idle, 1 = mozgás, 2 = lerepült
+	Integrator integrator = RK4;
+	WheelMesh* mesh;
 	Spline* track;
 	vec3 prevpos;
 	vec3 position;
 	vec3 cposition;
 	vec3 T;
 	vec3 N;
+	vec3 velocity; //lerepülés után a szabadon repülő kerék sebessége
 	float tau;
-	float v;
+	float ivhossz; //a megtett ívhossz, ebből számoljuk tau-t (nem halmozódik a lépésenkénti közelítés hibája)
+	float v; //előjeles pályamenti sebesség
 	float elfordulas;
+	float prevelfordulas;
 	float szogsebesseg;
 	float szoggyorsulas;
 	float tehetlennyomatek = 0.0f;
+	float accumulator = 0.0f; //a még le nem szimulált idő
+	float alpha = 0.0f; //a rajzolás helye az előző és a jelenlegi lépés között
 	vec3 gorbulet;
 	vec3 K;
 	const float g = 40.0f; 
+	const float radius = 2.0f;
 
-	Gondola(Spline* pTrack) {
+	Gondola(Spline* pTrack, WheelMesh* pMesh) {
 		track = pTrack;
+		mesh = pMesh;
 		State = 0; 
 	}
 
@@ -252,107 +883,294 @@ public:
 		if (State == 0 && track->ControlPoints.Vtx().size() >= 2) {
 			State = 1; 
 			tau = 0.01f;
+			ivhossz = track->ArcLength(tau);
 			v = 0.0f;
-			position = track->r(tau);
-			T = track->rt(tau) / length(track->rt(tau));
-			N.x = -T.y; N.y = T.x; N.z = 0.0f;
-			cposition = position + N * 2.0f;
+			UpdateFrame();
+			prevpos = cposition;
 			szogsebesseg = 0.0f;
+			szoggyorsulas = 0.0f;
 			elfordulas = 0.0f;
-
+			prevelfordulas = 0.0f;
+			accumulator = 0.0f;
+			alpha = 0.0f;
+		}
+	}
+	//Egy rögzített h hosszú lépés. Csak a lépésköztől és az állapottól függ, így a pálya visszajátszható.
+	void Step(float h) {
+		prevpos = cposition;
+		prevelfordulas = elfordulas;
+		if (State == 2) {
+			velocity.y -= g * h;
+			cposition = cposition + velocity * h;
+			elfordulas += szogsebesseg * h;
+			return;
+		}
+		if (State != 1) return;
+		float s0 = ivhossz;
+		Integrate(h);
+		float trackLength = track->Length();
+		bool offEnd = ivhossz < 0.0f || ivhossz > trackLength;
+		ivhossz = std::max(0.0f, std::min(ivhossz, trackLength));
+		UpdateFrame();
+		szogsebesseg = v / radius;
+		szoggyorsulas = Acceleration(ivhossz) / radius;
+		elfordulas += (ivhossz - s0) / radius;
+		//a pálya csak a kerék felé tud nyomni: ha ehhez húznia kellene, vagy a kerék elfogyott a pályáról, lerepül
+		if (offEnd || dot(K, N) < 0.0f) {
+			State = 2;
+			velocity = T * v;
 		}
 	}
+	//A képkockák közti valós idő rögzített lépésekre bontva, a maradék a rajzolásnál interpolál
 	void Animate(float dt) {
-		gorbulet = (track->rtt(tau) * N) / (length(track->r(tau)) * length(track->r(tau)));
-		K = (g * N + v * v * gorbulet);
-		if (length(K) >= 0) {
-			v = sqrt(2 * g * (track->ControlPoints.Vtx()[0].y - track->r(tau).y));
-			float Dtau = v * dt / length(track->rt(tau));
-			tau += Dtau;
-			position = track->r(tau);
-			T = track->rt(tau) / length(track->rt(tau));
-			N.x = -T.y; N.y = T.x; N.z = 0.0f;
-			cposition = position + N * 2.0f;
-			szogsebesseg = v / length(track->rt(tau));
-			szoggyorsulas = length(track->rtt(tau)) / length(track->rt(tau));
-			elfordulas += szogsebesseg * Dtau + 0.5f * szoggyorsulas * Dtau * Dtau;
-
-		}
-		if (length(K) < 0) {
+		if (State == 0) return;
+		accumulator = std::min(accumulator + dt, maxStepsPerFrame * physicsStep);
+		while (accumulator >= physicsStep) {
+			Step(physicsStep);
+			accumulator -= physicsStep;
 		}
-	
-	
-	
+		alpha = accumulator / physicsStep;
 	}
 
-	void Draw(GPUProgram* prog) {
-		if (position.x == 0.0f && position.y == 0.0f) return;
+	void Draw(RenderBackend* target, GPUProgram* prog) {
+		if (State == 0) return;
+		vec3 center = prevpos + (cposition - prevpos) * alpha;
+		if (!camera->Visible(center - vec3(radius, radius, 0.0f), center + vec3(radius, radius, 0.0f))) return;
+		mesh->Draw(target, prog, center, prevelfordulas + (elfordulas - prevelfordulas) * alpha);
+	}
+};
 
-		wheelBody.Vtx().clear();
-		wheelOutline.Vtx().clear();
-		spokes.Vtx().clear();
 
-		
-		for (int i = 0; i < 32; i++) { 
-			float theta = 2.0f * M_PI * float(i) / 32.0f;
-			float x = 2.0f *  cos(theta - elfordulas);
-			float y = 2.0f * sin(theta - elfordulas);
-			wheelOutline.Vtx().push_back(cposition + vec3(x, y, 0));
-			wheelBody.Vtx().push_back(cposition + vec3(x, y, 0));
-		}
 
 
-		for (int i = 0; i < 4; i++) { 
-			float theta = 2.0f * M_PI * float(i) / 4.0f;
-			float x = 2.0f * cos(theta - elfordulas);
-			float y = 2.0f *  sin(theta - elfordulas);
-			spokes.Vtx().push_back(cposition);
-			spokes.Vtx().push_back(cposition + vec3(x, y, 0));
-		}
+//Sok kerék ugyanazon a pályán, ugyanazzal a fizikával, mint a Gondola: (ívhossz, sebesség) állapot a választott
+//integrátorral, a dot(K, N) < 0 vagy a pálya végén lerepülés, utána ballisztikus repülés, és rajzoláskor interpoláció.
+//Az állapot oszloponként (SoA) tárolt, a lépés 64-es csomagokban halad: a gyorsulásokhoz és a kerethez kötegelt
+//pályakiértékelés, majd egyszerű ciklusok a tömbökön. A kerekek függetlenek, ezért egy csomag egymás után
+//az összes lépést megteszi, amíg az adatai a gyorsítótárban vannak; nagy darabszámnál a csomagokat képkockánként
+//egyszer osztjuk fel a szálak között, nem lépésenként. Egy kerék pályája bitre azonos a Gondola-éval.
+class GondolaSystem {
+	enum { chunk = 64 };
+	Spline* track;
+	WheelMesh* mesh;
+	const float g = 40.0f;
+	const float radius = 2.0f;
 
-	
-		wheelBody.Load();
-		wheelOutline.Load();
-		spokes.Load();
+	//Pályamenti gyorsulás a csomag mozgó kerekeinek s ívhosszánál (Gondola::Acceleration), a többinél tStart-ban számol
+	void Accelerations(const float* s, const int* pstate, int m, float tStart, float* a, int& hint) {
+		float t[chunk];
+		SplineSample samples[chunk];
+		for (int k = 0; k < m; k++) t[k] = pstate[k] == 1 ? track->ParamAt(s[k]) : tStart;
+		track->Eval(t, m, samples, &hint);
+		for (int k = 0; k < m; k++) a[k] = -g * samples[k].rt.y / length(samples[k].rt);
+	}
+	void StepRange(size_t begin, size_t end, int steps, float h) {
+		float t[chunk], s0[chunk], acc[4][chunk], stage[3][chunk], sv[3][chunk];
+		SplineSample samples[chunk];
+		int hint = 0;
+		float trackLength = track->Length(), tStart = track->ParamAt(0.0f);
+		for (size_t first = begin; first < end; first += chunk) {
+			int m = (int)std::min((size_t)chunk, end - first);
+			float* ps = &ivhossz[first];
+			float* pv = &v[first];
+			int* pstate = &state[first];
+			for (int step = 0; step < steps; step++) {
+				int moving = 0;
+				for (int k = 0; k < m; k++) {
+					size_t w = first + k;
+					prevpos[w] = cposition[w];
+					prevelfordulas[w] = elfordulas[w];
+					moving += pstate[k] == 1;
+					if (pstate[k] != 2) continue;
+					velocity[w].y -= g * h;
+					cposition[w] = cposition[w] + velocity[w] * h;
+					elfordulas[w] += szogsebesseg[w] * h;
+				}
+				if (moving == 0) continue;
+				for (int k = 0; k < m; k++) s0[k] = ps[k];
+				if (integrator == SEMI_IMPLICIT_EULER) {
+					Accelerations(ps, pstate, m, tStart, acc[0], hint);
+					for (int k = 0; k < m; k++) {
+						if (pstate[k] != 1) continue;
+						pv[k] += acc[0][k] * h;
+						ps[k] += pv[k] * h;
+					}
+				}
+				else {
+					Accelerations(ps, pstate, m, tStart, acc[0], hint);
+					for (int k = 0; k < m; k++) { stage[0][k] = ps[k] + 0.5f * h * pv[k]; sv[0][k] = pv[k] + 0.5f * h * acc[0][k]; }
+					Accelerations(stage[0], pstate, m, tStart, acc[1], hint);
+					for (int k = 0; k < m; k++) { stage[1][k] = ps[k] + 0.5f * h * sv[0][k]; sv[1][k] = pv[k] + 0.5f * h * acc[1][k]; }
+					Accelerations(stage[1], pstate, m, tStart, acc[2], hint);
+					for (int k = 0; k < m; k++) { stage[2][k] = ps[k] + h * sv[1][k]; sv[2][k] = pv[k] + h * acc[2][k]; }
+					Accelerations(stage[2], pstate, m, tStart, acc[3], hint);
+					for (int k = 0; k < m; k++) {
+						if (pstate[k] != 1) continue;
+						ps[k] += h / 6.0f * (pv[k] + 2.0f * sv[0][k] + 2.0f * sv[1][k] + sv[2][k]);
+						pv[k] += h / 6.0f * (acc[0][k] + 2.0f * acc[1][k] + 2.0f * acc[2][k] + acc[3][k]);
+					}
+				}
+				//a keret az új ívhossznál (Gondola::UpdateFrame), a pálya végén lerepül
+				bool offEnd[chunk];
+				for (int k = 0; k < m; k++) {
+					offEnd[k] = ps[k] < 0.0f || ps[k] > trackLength;
+					if (pstate[k] == 1) ps[k] = std::max(0.0f, std::min(ps[k], trackLength));
+					t[k] = pstate[k] == 1 ? track->ParamAt(ps[k]) : tStart;
+				}
+				track->Eval(t, m, samples, &hint);
+				for (int k = 0; k < m; k++) {
+					if (pstate[k] != 1) continue;
+					size_t w = first + k;
+					tau[w] = t[k];
+					float rtlen = length(samples[k].rt);
+					vec3 T = samples[k].rt / rtlen;
+					vec3 N(-T.y, T.x, 0.0f);
+					cposition[w] = samples[k].r + N * radius;
+					float kappa = (samples[k].rt.x * samples[k].rtt.y - samples[k].rt.y * samples[k].rtt.x) / (rtlen * rtlen * rtlen);
+					vec3 K = N * (pv[k] * pv[k] * kappa + g * N.y);
+					szogsebesseg[w] = pv[k] / radius;
+					elfordulas[w] += (ps[k] - s0[k]) / radius;
+					if (offEnd[k] || dot(K, N) < 0.0f) {
+						pstate[k] = 2;
+						velocity[w] = T * pv[k];
+					}
+				}
+			}
+		}
+	}
+public:
+	//1 = a pályán mozog, 2 = lerepült (mint Gondola::State)
+	std::vector<float> tau, ivhossz, v, elfordulas, prevelfordulas, szogsebesseg;
+	std::vector<int> state;
+	std::vector<vec3> cposition, prevpos, velocity;
+	Integrator integrator = RK4;
+	float accumulator = 0.0f;
+	float alpha = 0.0f; //a rajzolás helye az előző és a jelenlegi lépés között
 
-		glLineWidth(3.0f);
-		wheelBody.Draw(prog, GL_TRIANGLE_FAN, vec3(1.0f, 1.0f, 1.0f), 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 0.0f));
-		wheelOutline.Draw(prog, GL_LINE_LOOP, vec3(1.0f, 1.0f, 1.0f), 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 0.0f));
-		spokes.Draw(prog, GL_LINES, vec3(1.0f, 1.0f, 1.0f), 0.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, 0.0f));
+	GondolaSystem(Spline* pTrack, WheelMesh* pMesh) : track(pTrack), mesh(pMesh) {}
+	size_t Count() { return tau.size(); }
+	//Új kerék a pálya elejétől s ívhosszra, álló helyzetből indulva
+	void Add(float s) {
+		if (track->ControlPoints.Vtx().size() < 2) return;
+		s = std::max(0.0f, std::min(s, track->Length()));
+		float t = track->ParamAt(s);
+		SplineSample sample = track->Eval(t);
+		vec3 T = sample.rt / length(sample.rt);
+		vec3 center = sample.r + vec3(-T.y, T.x, 0.0f) * radius;
+		tau.push_back(t);
+		ivhossz.push_back(s);
+		v.push_back(0.0f);
+		elfordulas.push_back(0.0f);
+		prevelfordulas.push_back(0.0f);
+		szogsebesseg.push_back(0.0f);
+		state.push_back(1);
+		cposition.push_back(center);
+		prevpos.push_back(center);
+		velocity.push_back(vec3(0.0f, 0.0f, 0.0f));
+	}
+	//steps darab dt hosszú lépés minden keréken; a szálak egyszer indulnak, és mindegyik a saját kerekeit lépteti végig
+	void Step(int steps, float dt) {
+		if (tau.empty() || steps <= 0) return;
+		track->Length(); //a táblázat elkészül, a szálak már csak olvassák
+		size_t n = tau.size();
+		int nthreads = n < 4096 ? 1 : std::max(1, (int)std::thread::hardware_concurrency());
+		if (nthreads <= 1) { StepRange(0, n, steps, dt); return; }
+		std::vector<std::thread> workers;
+		for (int w = 0; w < nthreads; w++) {
+			workers.push_back(std::thread(&GondolaSystem::StepRange, this, n * w / nthreads, n * (w + 1) / nthreads, steps, dt));
+		}
+		for (auto& worker : workers) worker.join();
+	}
+	//Rögzített lépésekre bontva, mint Gondola::Animate; a képkocka összes lépése egy Step hívásban
+	void Advance(float dt) {
+		accumulator = std::min(accumulator + dt, maxStepsPerFrame * physicsStep);
+		int steps = 0;
+		while (accumulator >= physicsStep) {
+			steps++;
+			accumulator -= physicsStep;
+		}
+		Step(steps, physicsStep);
+		alpha = accumulator / physicsStep;
+	}
+	void Draw(RenderBackend* target, GPUProgram* prog) {
+		std::vector<vec3> instances;
+		instances.reserve(cposition.size());
+		vec3 r(radius, radius, 0.0f);
+		for (size_t w = 0; w < cposition.size(); w++) {
+			vec3 center = prevpos[w] + (cposition[w] - prevpos[w]) * alpha;
+			float angle = prevelfordulas[w] + (elfordulas[w] - prevelfordulas[w]) * alpha;
+			if (camera->Visible(center - r, center + r)) instances.push_back(vec3(center.x, center.y, -angle));
+		}
+		mesh->DrawInstanced(target, prog, instances);
 	}
 };
 
 
+//Egy képkocka a szoftveres raszterizálóval, ugyanazokkal a rajzoló hívásokkal és sorrendben, mint az ablakban
+void RenderFrame(SoftwareRenderer& renderer, Spline* track, Gondola* gondola, GondolaSystem* gondolas) {
+	renderer.Clear(vec3(0.0f, 0.0f, 0.0f));
+	if (gondola) gondola->Draw(&renderer, nullptr);
+	if (gondolas) gondolas->Draw(&renderer, nullptr);
+	track->Draw(&renderer, nullptr);
+	renderer.Finish();
+}
+//GPU nélküli visszajátszás: frames képkocka, mindegyik előtt dt idővel léptetve, a pattern (pl. "gondola_%05d.ppm") szerinti fájlokba.
+//A visszatérési érték a kiírt képkockák száma.
+int RenderOffline(Spline* track, Gondola* gondola, GondolaSystem* gondolas, int frames, float dt, const char* pattern) {
+	SoftwareRenderer renderer(winWidth, winHeight);
+	char filename[256];
+	for (int frame = 0; frame < frames; frame++) {
+		if (gondola) gondola->Animate(dt);
+		if (gondolas) gondolas->Advance(dt);
+		RenderFrame(renderer, track, gondola, gondolas);
+		snprintf(filename, sizeof(filename), pattern, frame);
+		if (!renderer.WritePPM(filename)) return frame;
+	}
+	return frames;
+}
 
 
 	class GreenTriangleApp : public glApp {
 	public:
-		GPUProgram* gpuProgram;	   // cscspont s pixel rnyalk
+		GPUProgram* gpuProgram;	   // csúcspont és pixel árnyalók
 		Primitive2D* triangle;
 		Gondola* gondola;
+		WheelMesh* wheelMesh;
+		GondolaSystem* gondolas;
 		float t;
 		bool moving;
 		Spline* CattMullSpline;
+		SoftwareRenderer* capture = nullptr; //ha be van kapcsolva, minden kirajzolt kép fájlba is kerül
+		int captureFrame = 0;
 		GreenTriangleApp() : glApp("Green triangle") {}
 
-		// Inicializci, 
+		// Inicializáció, 
 		void onInitialization() {
 			camera = new Camera(vec3(0.0f, 0.0f, 0.0f), vec3(20.0f, 20.0f, 1.0f));
 			t = 0.01;
 			moving = false;
 			CattMullSpline = new Spline();
-			gondola = new Gondola(CattMullSpline);
+			wheelMesh = new WheelMesh();
+			gondola = new Gondola(CattMullSpline, wheelMesh);
+			gondolas = new GondolaSystem(CattMullSpline, wheelMesh);
 			gpuProgram = new GPUProgram(vertSource, fragSource);
 
 		}
 
-		// Ablak jrarajzols
+		// Ablak újrarajzolás
 		void onDisplay() {
-			glClearColor(0, 0, 0, 0);     // httr szn
-			glClear(GL_COLOR_BUFFER_BIT); // rasztertr trls
+			glClearColor(0, 0, 0, 0);     // háttér szín
+			glClear(GL_COLOR_BUFFER_BIT); // rasztertár törlés
 			glViewport(0, 0, winWidth, winHeight);
-			gondola->Draw(gpuProgram);
-			CattMullSpline->Draw(gpuProgram);
+			gondola->Draw(backend, gpuProgram);
+			gondolas->Draw(backend, gpuProgram);
+			CattMullSpline->Draw(backend, gpuProgram);
+			if (capture) {
+				char filename[64];
+				snprintf(filename, sizeof(filename), "gondola_%05d.ppm", captureFrame++);
+				RenderFrame(*capture, CattMullSpline, gondola, gondolas);
+				capture->WritePPM(filename);
+			}
 		
 		}
 		void onMousePressed(MouseButton but, int pX, int pY) {
@@ -375,15 +1193,47 @@ public:
 		void onKeyboard(int key) {
 			if (key == ' ') { 
 				gondola->Start();
-				gondola->Draw(gpuProgram);
+				gondola->Draw(backend, gpuProgram);
 				refreshScreen();
 				moving = true;
 			}
+			//integrátor váltása (a következő lépéstől érvényes)
+			if (key == 'e') {
+				gondola->integrator = gondola->integrator == RK4 ? SEMI_IMPLICIT_EULER : RK4;
+				LOG(LOG_INFO, LOG_GENERAL, "Integrator: %s", gondola->integrator == RK4 ? "RK4" : "semi-implicit Euler");
+			}
+			//nagyítás, kicsinyítés és mozgatás; a görbét az új léptékhez bontjuk újra
+			if (key == '+' || key == '-') {
+				camera->Zoom(key == '+' ? 0.8f : 1.25f);
+				CattMullSpline->AddSpline();
+				refreshScreen();
+			}
+			if (key == 'w' || key == 'a' || key == 's' || key == 'd') {
+				vec3 step = camera->Size() * 0.1f;
+				if (key == 'w') camera->Pan(vec3(0.0f, step.y, 0.0f));
+				if (key == 's') camera->Pan(vec3(0.0f, -step.y, 0.0f));
+				if (key == 'a') camera->Pan(vec3(-step.x, 0.0f, 0.0f));
+				if (key == 'd') camera->Pan(vec3(step.x, 0.0f, 0.0f));
+				refreshScreen();
+			}
+			//képkockák mentése a szoftveres raszterizálóval (gondola_00000.ppm, ...)
+			if (key == 'c') {
+				if (capture) { delete capture; capture = nullptr; }
+				else capture = new SoftwareRenderer(winWidth, winHeight);
+				LOG(LOG_INFO, LOG_GENERAL, "Capture: %s", capture ? "on" : "off");
+			}
+			//további 100 kerék a pálya első tizedén elosztva
+			if (key == 'g') {
+				for (int i = 0; i < 100; i++) gondolas->Add(CattMullSpline->Length() * 0.001f * (i + 1));
+				moving = true;
+				refreshScreen();
+			}
 		}
 		void onTimeElapsed(float startTime, float endTime) {
 			if (moving) {
 				const float dt = fabs(startTime- endTime);
 				gondola->Animate(dt);
+				gondolas->Advance(dt);
 				refreshScreen();
 			}
 		}
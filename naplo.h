@@ -0,0 +1,108 @@
+//=============================================================================================
+// Eseménynapló: szintek, kategóriánkénti mintavétel, gyűrűpuffer és háttérszálas kiírás
+//=============================================================================================
+#pragma once
+#include <cstdio>
+#include <cstdarg>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+enum LogLevel { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_OFF };
+enum LogCategory { LOG_GENERAL, LOG_EDIT, LOG_DRAG, LOG_PATH, LOG_CATEGORIES };
+
+//A hívó csak beírja az üzenetet a gyűrűpufferbe, a konzolra a háttérszál ír.
+//Ha a puffer megtelik, az új üzenetek eldobódnak (a számukat a következő kiírás jelzi), így a hívó sosem vár a terminálra.
+class EventLog {
+	static const int capacity = 1024;
+	struct Entry {
+		LogLevel level;
+		LogCategory category;
+		char text[160];
+	};
+	Entry ring[capacity];
+	int head = 0, count = 0;
+	long dropped = 0;
+	std::atomic<int> level{ LOG_INFO };
+	std::atomic<unsigned> sampling[LOG_CATEGORIES];	//kategóriánként minden hányadik üzenet kerül a naplóba
+	std::atomic<unsigned> counter[LOG_CATEGORIES];
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::thread writer;
+	bool running = false;
+	FILE* out = stdout;
+
+	void Write() {
+		static const char* levels[] = { "debug", "info", "warn", "error" };
+		static const char* categories[] = { "general", "edit", "drag", "path" };
+		std::unique_lock<std::mutex> lock(mutex);
+		while (running || count > 0) {
+			wakeup.wait(lock, [this]() { return !running || count > 0; });
+			while (count > 0) {
+				Entry entry = ring[head];
+				head = (head + 1) % capacity;
+				count--;
+				long lost = dropped;
+				dropped = 0;
+				FILE* file = out;
+				lock.unlock();
+				if (lost > 0) fprintf(file, "[warn][general] %ld log messages dropped\n", lost);
+				fprintf(file, "[%s][%s] %s\n", levels[entry.level], categories[entry.category], entry.text);
+				lock.lock();
+			}
+			fflush(out);
+		}
+	}
+public:
+	EventLog() {
+		for (int c = 0; c < LOG_CATEGORIES; c++) { sampling[c] = 1; counter[c] = 0; }
+	}
+	void SetLevel(LogLevel nlevel) { level = nlevel; }
+	LogLevel Level() { return (LogLevel)level.load(); }
+	void SetSampling(LogCategory category, unsigned every) { sampling[category] = every > 0 ? every : 1; }
+	//A kiírás célja (alapból a konzol); a napló nem zárja le
+	void SetOutput(FILE* nout) {
+		std::lock_guard<std::mutex> lock(mutex);
+		fflush(out);
+		out = nout;
+	}
+	//Gyors előszűrés: kikapcsolt szintnél csak egy összehasonlítás
+	bool Enabled(LogLevel nlevel, LogCategory category) {
+		if (nlevel < level.load(std::memory_order_relaxed)) return false;
+		unsigned every = sampling[category].load(std::memory_order_relaxed);
+		return every == 1 || counter[category].fetch_add(1, std::memory_order_relaxed) % every == 0;
+	}
+	void Log(LogLevel nlevel, LogCategory category, const char* format, ...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running) { running = true; writer = std::thread(&EventLog::Write, this); }
+		if (count == capacity) { dropped++; return; }
+		Entry& entry = ring[(head + count) % capacity];
+		entry.level = nlevel;
+		entry.category = category;
+		va_list args;
+		va_start(args, format);
+		vsnprintf(entry.text, sizeof(entry.text), format, args);
+		va_end(args);
+		count++;
+		wakeup.notify_one();
+	}
+	//A pufferben maradt üzenetek kiírása, majd a háttérszál leállítása
+	~EventLog() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!running) return;
+			running = false;
+		}
+		wakeup.notify_one();
+		writer.join();
+	}
+};
+
+inline EventLog& eventLog() {
+	static EventLog log;
+	return log;
+}
+
+//A formázás csak akkor fut le, ha a szint és a mintavétel átengedi az üzenetet
+#define LOG(level, category, ...) do { if (eventLog().Enabled(level, category)) eventLog().Log(level, category, __VA_ARGS__); } while (0)
@@ -1,9 +1,23 @@
 //=============================================================================================
-// Zld hromszg: A framework.h osztlyait felhasznl megolds
+// Zöld háromszög: A framework.h osztályait felhasználó megoldás
 //=============================================================================================
 #include "framework.h"
-
-// cscspont rnyal
+#include "naplo.h"
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// csúcspont árnyaló
 const char* vertSource = R"(
 	#version 330
     precision highp float;
@@ -20,7 +34,7 @@ const char* vertSource = R"(
 	}
 )";
 
-// pixel rnyal
+// pixel árnyaló
 const char* fragSource = R"(
 #version 330
 precision highp float;
@@ -88,6 +102,165 @@ vec2 MapToMercator(const vec2& map) {
 	float y = log(tan(M_PI / 4.0f + map.y / 2.0f)) / M_PI;
 	return vec2(x, y);
 }
+//Polinomos közelítések a kötegelt vetítésekhez (a hibakorlátok a közelítés saját hibái, ehhez jön a float kerekítés):
+//  FastAtan: [0, 1]-en Abramowitz-Stegun 4.4.49, |hiba| <= 1e-5 rad
+//  FastLn: mantissza [sqrt(1/2), sqrt(2)]-be, majd 2*atanh((m-1)/(m+1)) sora s^9-ig, |hiba| <= 1e-9
+//  FastSin: [0, pi]-n, pi/2-re tükrözve, Taylor-sor x^11-ig, |hiba| <= 6e-8
+//Az AVX2 ágak ugyanezeket a polinomokat számolják 8 sávon; a két ág csak a kerekítésben (pl. FMA) térhet el.
+//A teljes lánc hibája |szélesség| <= 85 fokig: x-ben <= 4e-6, y-ban <= 1e-5 Mercator-egység (600 pixeles ablakban 0.003 pixel).
+const float atanCoeffs[6] = { 0.99997726f, -0.33262347f, 0.19354346f, -0.11643287f, 0.05265332f, -0.01172120f };
+
+inline float FastAtan(float a) {
+	float a2 = a * a;
+	float p = atanCoeffs[5];
+	for (int i = 4; i >= 0; i--) p = p * a2 + atanCoeffs[i];
+	return p * a;
+}
+inline float FastAtan2(float y, float x) {
+	float ax = fabs(x), ay = fabs(y);
+	float mx = std::max(ax, ay), mn = std::min(ax, ay);
+	float r = FastAtan(mx > 0.0f ? mn / mx : 0.0f);
+	if (ay > ax) r = float(M_PI / 2) - r;
+	if (x < 0.0f) r = float(M_PI) - r;
+	return y < 0.0f ? -r : r;
+}
+inline float FastLn(float x) {
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	int e = int(bits >> 23) - 127;
+	bits = (bits & 0x7fffff) | 0x3f800000;
+	float m;
+	memcpy(&m, &bits, sizeof(m));
+	if (m > 1.41421356f) { m *= 0.5f; e++; }
+	float s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+	float p = (((s2 * (1.0f / 9.0f) + 1.0f / 7.0f) * s2 + 1.0f / 5.0f) * s2 + 1.0f / 3.0f) * s2 + 1.0f;
+	return float(e) * 0.69314718f + 2.0f * s * p;
+}
+inline float FastSin(float x) {
+	x = std::min(x, float(M_PI) - x);
+	float x2 = x * x;
+	float p = ((((x2 * (-1.0f / 39916800.0f) + 1.0f / 362880.0f) * x2 - 1.0f / 5040.0f) * x2 + 1.0f / 120.0f) * x2 - 1.0f / 6.0f) * x2 + 1.0f;
+	return p * x;
+}
+//Gömbi pont (nem feltétlenül egységnyi) -> Mercator: SphereToMap és MapToMercator egyben.
+//log(tan(pi/4 + lat/2)) = atanh(sin(lat)) = ln((1 + z) / (1 - z)) / 2, így asin és tan nem kell.
+inline vec2 SphereToMercatorFast(float x, float y, float z) {
+	float sz = z / sqrt(x * x + y * y + z * z);
+	sz = std::max(-0.9999999f, std::min(sz, 0.9999999f));
+	return vec2(FastAtan2(y, x) * float(1.0 / M_PI), 0.5f * FastLn((1.0f + sz) / (1.0f - sz)) * float(1.0 / M_PI));
+}
+
+#ifdef __AVX2__
+inline __m256 FastAtan2x8(__m256 y, __m256 x) {
+	__m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)), zero = _mm256_setzero_ps();
+	__m256 ax = _mm256_and_ps(x, absmask), ay = _mm256_and_ps(y, absmask);
+	__m256 mx = _mm256_max_ps(ax, ay), mn = _mm256_min_ps(ax, ay);
+	__m256 a = _mm256_blendv_ps(zero, _mm256_div_ps(mn, mx), _mm256_cmp_ps(mx, zero, _CMP_GT_OQ));
+	__m256 a2 = _mm256_mul_ps(a, a);
+	__m256 p = _mm256_set1_ps(atanCoeffs[5]);
+	for (int i = 4; i >= 0; i--) p = _mm256_add_ps(_mm256_mul_ps(p, a2), _mm256_set1_ps(atanCoeffs[i]));
+	__m256 r = _mm256_mul_ps(p, a);
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(float(M_PI / 2)), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+	r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(float(M_PI)), r), _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+	return _mm256_blendv_ps(r, _mm256_sub_ps(zero, r), _mm256_cmp_ps(y, zero, _CMP_LT_OQ));
+}
+inline __m256 FastLnx8(__m256 x) {
+	__m256i bits = _mm256_castps_si256(x);
+	__m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x7fffff)), _mm256_set1_epi32(0x3f800000)));
+	__m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+	__m256 ef = _mm256_add_ps(_mm256_cvtepi32_ps(e), _mm256_and_ps(big, _mm256_set1_ps(1.0f)));
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 s = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one)), s2 = _mm256_mul_ps(s, s);
+	__m256 p = _mm256_add_ps(_mm256_mul_ps(s2, _mm256_set1_ps(1.0f / 9.0f)), _mm256_set1_ps(1.0f / 7.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(1.0f / 5.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, s2), _mm256_set1_ps(1.0f / 3.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, s2), one);
+	return _mm256_add_ps(_mm256_mul_ps(ef, _mm256_set1_ps(0.69314718f)), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(2.0f), s), p));
+}
+inline __m256 FastSinx8(__m256 x) {
+	x = _mm256_min_ps(x, _mm256_sub_ps(_mm256_set1_ps(float(M_PI)), x));
+	__m256 x2 = _mm256_mul_ps(x, x);
+	__m256 p = _mm256_add_ps(_mm256_mul_ps(x2, _mm256_set1_ps(-1.0f / 39916800.0f)), _mm256_set1_ps(1.0f / 362880.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(-1.0f / 5040.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(1.0f / 120.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(-1.0f / 6.0f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(1.0f));
+	return _mm256_mul_ps(p, x);
+}
+inline void SphereToMercatorx8(__m256 x, __m256 y, __m256 z, float* mx, float* my) {
+	__m256 r = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+	__m256 sz = _mm256_div_ps(z, r);
+	sz = _mm256_max_ps(_mm256_set1_ps(-0.9999999f), _mm256_min_ps(sz, _mm256_set1_ps(0.9999999f)));
+	__m256 one = _mm256_set1_ps(1.0f), invpi = _mm256_set1_ps(float(1.0 / M_PI));
+	_mm256_storeu_ps(mx, _mm256_mul_ps(FastAtan2x8(y, x), invpi));
+	__m256 l = FastLnx8(_mm256_div_ps(_mm256_add_ps(one, sz), _mm256_sub_ps(one, sz)));
+	_mm256_storeu_ps(my, _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), l), invpi));
+}
+#endif
+
+//n gömbi pont (SoA) Mercator-koordinátái
+void SphereToMercatorBatch(const float* x, const float* y, const float* z, int n, float* mx, float* my) {
+	int k = 0;
+#ifdef __AVX2__
+	for (; k + 8 <= n; k += 8) SphereToMercatorx8(_mm256_loadu_ps(x + k), _mm256_loadu_ps(y + k), _mm256_loadu_ps(z + k), mx + k, my + k);
+#endif
+	for (; k < n; k++) {
+		vec2 m = SphereToMercatorFast(x[k], y[k], z[k]);
+		mx[k] = m.x; my[k] = m.y;
+	}
+}
+//A start-end főkör t[k] paraméterű pontjai Mercator-koordinátákban, egy menetben: slerp -> gömb -> térkép -> Mercator.
+//D a két egységvektor szöge (0 < D < pi).
+void GreatCircleBatch(const vec3& start, const vec3& end, float D, const float* t, int n, float* mx, float* my) {
+	float inv = 1.0f / sin(D);
+	int k = 0;
+#ifdef __AVX2__
+	__m256 d = _mm256_set1_ps(D), vinv = _mm256_set1_ps(inv), one = _mm256_set1_ps(1.0f);
+	__m256 sx = _mm256_set1_ps(start.x), sy = _mm256_set1_ps(start.y), sz = _mm256_set1_ps(start.z);
+	__m256 ex = _mm256_set1_ps(end.x), ey = _mm256_set1_ps(end.y), ez = _mm256_set1_ps(end.z);
+	for (; k + 8 <= n; k += 8) {
+		__m256 tk = _mm256_loadu_ps(t + k);
+		__m256 a = _mm256_mul_ps(FastSinx8(_mm256_mul_ps(_mm256_sub_ps(one, tk), d)), vinv);
+		__m256 b = _mm256_mul_ps(FastSinx8(_mm256_mul_ps(tk, d)), vinv);
+		__m256 px = _mm256_add_ps(_mm256_mul_ps(a, sx), _mm256_mul_ps(b, ex));
+		__m256 py = _mm256_add_ps(_mm256_mul_ps(a, sy), _mm256_mul_ps(b, ey));
+		__m256 pz = _mm256_add_ps(_mm256_mul_ps(a, sz), _mm256_mul_ps(b, ez));
+		SphereToMercatorx8(px, py, pz, mx + k, my + k);
+	}
+#endif
+	for (; k < n; k++) {
+		float a = FastSin((1.0f - t[k]) * D) * inv, b = FastSin(t[k] * D) * inv;
+		vec2 m = SphereToMercatorFast(a * start.x + b * end.x, a * start.y + b * end.y, a * start.z + b * end.z);
+		mx[k] = m.x; my[k] = m.y;
+	}
+}
+//n földrajzi pont (fokban, SoA) Mercator-koordinátái, a MapToMercator kötegelt változata:
+//y = atanh(sin(lat)) / pi, ugyanazokkal a polinomokkal, mint a fenti kernelek
+void MapToMercatorBatch(const float* lat, const float* lon, int n, float* mx, float* my) {
+	const float toRad = float(M_PI / 180.0), lim = 0.9999999f;
+	int k = 0;
+#ifdef __AVX2__
+	__m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)), one = _mm256_set1_ps(1.0f);
+	for (; k + 8 <= n; k += 8) {
+		__m256 la = _mm256_mul_ps(_mm256_loadu_ps(lat + k), _mm256_set1_ps(toRad));
+		__m256 sign = _mm256_andnot_ps(absmask, la);
+		__m256 sz = _mm256_or_ps(FastSinx8(_mm256_and_ps(la, absmask)), sign);
+		sz = _mm256_max_ps(_mm256_set1_ps(-lim), _mm256_min_ps(sz, _mm256_set1_ps(lim)));
+		__m256 l = FastLnx8(_mm256_div_ps(_mm256_add_ps(one, sz), _mm256_sub_ps(one, sz)));
+		_mm256_storeu_ps(mx + k, _mm256_mul_ps(_mm256_loadu_ps(lon + k), _mm256_set1_ps(1.0f / 180.0f)));
+		_mm256_storeu_ps(my + k, _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), l), _mm256_set1_ps(float(1.0 / M_PI))));
+	}
+#endif
+	for (; k < n; k++) {
+		float la = lat[k] * toRad;
+		float sz = la < 0.0f ? -FastSin(-la) : FastSin(la);
+		sz = std::max(-lim, std::min(sz, lim));
+		mx[k] = lon[k] * (1.0f / 180.0f);
+		my[k] = 0.5f * FastLn((1.0f + sz) / (1.0f - sz)) * float(1.0 / M_PI);
+	}
+}
 class Texture2 {
 	unsigned int textureId = 0;
 public:
@@ -183,11 +356,41 @@ public:
 		glDeleteVertexArrays(1, &vao);
 	}
 };
-class Station : public Geometry<vec2> {
+//Csak hozzáfűzéssel bővülő geometria: a GPU-ra csak a változott tartomány megy fel, a puffer duplázással nő
+class Object : public Geometry<vec2> {
+	size_t capacity = 0;				 //a GPU pufferben lefoglalt csúcsok száma
+	size_t dirtyBegin = 0, dirtyEnd = 0; //a GPU-ra még fel nem töltött csúcsok tartománya
+protected:
+	void MarkDirty(size_t first, size_t count) {
+		if (dirtyBegin == dirtyEnd) { dirtyBegin = first; dirtyEnd = first + count; return; }
+		dirtyBegin = std::min(dirtyBegin, first);
+		dirtyEnd = std::max(dirtyEnd, first + count);
+	}
+public:
+	void SyncGPU() {
+		if (vtx.empty() || dirtyBegin == dirtyEnd) return;
+		Bind();
+		if (vtx.size() > capacity) {
+			capacity = std::max(vtx.size(), capacity * 2);
+			glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(vec2), NULL, GL_DYNAMIC_DRAW);
+			dirtyBegin = 0; dirtyEnd = vtx.size();
+		}
+		dirtyEnd = std::min(dirtyEnd, vtx.size());
+		if (dirtyBegin < dirtyEnd) glBufferSubData(GL_ARRAY_BUFFER, dirtyBegin * sizeof(vec2), (dirtyEnd - dirtyBegin) * sizeof(vec2), &vtx[dirtyBegin]);
+		dirtyBegin = dirtyEnd = 0;
+	}
+};
+class Station : public Object {
 public:
 	void addStation(const vec2& position) {
+		MarkDirty(vtx.size(), 1);
 		vtx.push_back(position);
-		updateGPU();
+		SyncGPU();
+	}
+	//Sok állomás egyszerre; a feltöltés a hívó SyncGPU-jával egyben történik
+	void addStations(const vec2* positions, size_t n) {
+		MarkDirty(vtx.size(), n);
+		vtx.insert(vtx.end(), positions, positions + n);
 	}
 	void drawStation(GPUProgram* gpuProgram) {
 		if (this->Vtx().size() == 0) return;
@@ -198,41 +401,416 @@ public:
 
 
 };
-class Path : public Geometry<vec2> {
+//Az előre felbontott útvonal fájljának fejléce; utána stations db állomás, vertices db csúcs (vec2),
+//majd strips db sávkezdet és strips db sávhossz (int)
+struct PathFileHeader {
+	char magic[4];	//"PTH1"
+	uint32_t stations, vertices, strips, legs;
+	uint32_t closeVertices, closeStrips;
+	int32_t closeLastCount;
+	uint32_t closeFlags;
+	float closeLastX, closeLastY;
+	uint32_t flags;
+	float lastX, lastY;
+};
+//Állomásonként egy főkör-ív. Új állomásnál csak az utolsó szakasz készül el és megy fel a GPU-ra,
+//így egy kattintás költsége nem függ a már meglévő állomások számától.
+class Path : public Object {
+	//Egy még vizsgálandó paraméter-intervallum és végpontjainak Mercator-képe
+	struct Interval {
+		float t0, t1;
+		vec2 m0, m1;
+	};
+	//A töröttvonal-építés állapota: a befejezett sávok és az utolsó (nyers) minta. A záró állomás előtt elmentjük,
+	//hogy a következő szakasz innen folytathassa.
+	struct Cursor {
+		size_t vertices = 0, strips = 0;
+		int lastCount = 0;
+		bool open = false, hasLast = false;
+		vec2 last;
+	};
+	std::vector<int> stripFirst, stripCount; //egymás utáni sávok a közös pufferben, egy MultiDrawArrays hívással
+	bool open = false; //az utolsó sáv folytatható-e
+	bool hasLast = false;
+	vec2 last; //az előző minta, a [-1, 1] x-tartományba visszahajtva
+	Cursor beforeClose;
+	//az AppendArc munkaterülete, szakaszok között újrahasználva
+	std::vector<std::pair<float, vec2>> samples;
+	std::vector<Interval> openIntervals, nextIntervals;
+	std::vector<float> tm, mmx, mmy;
+	const float latitudeLimit = 1.0f; //Mercator y korlát (kb. 85 fok), ezen túl a térkép nem látszik
+	size_t legs = 0; //ennyi szakasz pontjai vannak már vtx-ben
+	float tolerance = 0.5f; //a töröttvonal megengedett eltérése a főkörtől, pixelben
+	const float maxAngle = 0.25f; //ennél hosszabb ív (radián) mindenképp felezendő, hogy S alakú szakasz se maradjon ki
+	const int maxDepth = 12;
+
+	//p.x eltolása 2 többszörösével x0 közelébe, hogy a dátumválasztón átlépő húr ne tűnjön hosszúnak
+	static vec2 Unwrap(vec2 p, float x0) {
+		while (p.x - x0 > 1.0f) p.x -= 2.0f;
+		while (p.x - x0 < -1.0f) p.x += 2.0f;
+		return p;
+	}
+	Cursor Save() {
+		Cursor c;
+		c.vertices = vtx.size(); c.strips = stripFirst.size(); c.lastCount = stripCount.empty() ? 0 : stripCount.back();
+		c.open = open; c.hasLast = hasLast; c.last = last;
+		return c;
+	}
+	void Restore(const Cursor& c) {
+		vtx.resize(c.vertices);
+		stripFirst.resize(c.strips); stripCount.resize(c.strips);
+		if (!stripCount.empty()) stripCount.back() = c.lastCount;
+		open = c.open; hasLast = c.hasLast; last = c.last;
+	}
+	void Push(const vec2& p, bool newStrip) {
+		if (newStrip || !open) {
+			stripFirst.push_back((int)vtx.size());
+			stripCount.push_back(0);
+			open = true;
+		}
+		vtx.push_back(p);
+		stripCount.back()++;
+	}
+	//Az a -> b szakasz levágása a |y| <= latitudeLimit sávra; ha a szakasz kilép, a sáv lezárul
+	void ClipLatitude(vec2 a, vec2 b, bool newStrip) {
+		float lim = latitudeLimit;
+		if ((a.y > lim && b.y > lim) || (a.y < -lim && b.y < -lim)) { open = false; return; }
+		vec2 ca = a, cb = b;
+		if (fabs(a.y) > lim) { float y = a.y > 0 ? lim : -lim; ca = a + (b - a) * ((y - a.y) / (b.y - a.y)); }
+		if (fabs(b.y) > lim) { float y = b.y > 0 ? lim : -lim; cb = a + (b - a) * ((y - a.y) / (b.y - a.y)); }
+		bool entered = ca.x != a.x || ca.y != a.y;
+		if (newStrip || entered || !open) Push(ca, true);
+		Push(cb, false);
+		if (cb.x != b.x || cb.y != b.y) open = false;
+	}
+	//Új minta a töröttvonal végére. A dátumválasztón (x = +-1) átlépő szakaszt a metszéspontban kettévágjuk,
+	//a két fele külön sávba kerül; a nagyon magas szélességeken túli részeket elhagyjuk.
+	void Emit(const vec2& p) {
+		if (!hasLast) {
+			hasLast = true;
+			last = p;
+			if (fabs(p.y) <= latitudeLimit) Push(p, true);
+			else open = false;
+			return;
+		}
+		//a pontosan a dátumválasztóra eső minta x = -1 és x = 1 is lehet, ezért a sávba ténylegesen került
+		//(visszahajtott) pontot jegyezzük meg, nem a nyers mintát
+		vec2 q = Unwrap(p, last.x);
+		if (q.x > 1.0f || q.x < -1.0f) {
+			float edge = q.x > 1.0f ? 1.0f : -1.0f;
+			vec2 c = last + (q - last) * ((edge - last.x) / (q.x - last.x));
+			c.x = edge;
+			if (last.x != edge) ClipLatitude(last, c, false);
+			q = q - vec2(2.0f * edge, 0.0f);
+			ClipLatitude(vec2(-edge, c.y), q, true);
+		}
+		else ClipLatitude(last, q, false);
+		last = q;
+	}
+	//Egy főkör-ív pontjai a kezdőponttal, a végpont nélkül. Szintenként felezünk: az egy szinten vizsgálandó
+	//felezőpontokat egy kötegben számoljuk, és ott vágunk tovább, ahol a felezőpont Mercatorban a húrtól a tűrésnél messzebb van.
+	void AppendArc(const vec3& start, const vec3& end) {
+		float D = acos(std::max(-1.0f, std::min(dot(start, end), 1.0f)));
+		float t[2] = { 0.0f, 1.0f }, mx[2], my[2];
+		//egybeeső állomások: nincs ív, csak a kezdőpont
+		if (D < 1e-6f) {
+			Emit(SphereToMercatorFast(start.x, start.y, start.z));
+			return;
+		}
+		//(közel) átellenes állomások: a főkör nem egyértelmű, a kezdőponton és az északi póluson átmenő kört választjuk
+		if (float(M_PI) - D < 1e-3f) {
+			vec3 pole = fabs(start.z) < 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+			vec3 mid = normalize(pole - start * dot(pole, start));
+			AppendArc(start, mid);
+			AppendArc(mid, end);
+			return;
+		}
+		float tol = tolerance * 2.0f / winWidth;
+		GreatCircleBatch(start, end, D, t, 2, mx, my);
+		samples.assign(1, std::make_pair(0.0f, vec2(mx[0], my[0])));
+		std::vector<Interval>& open = openIntervals;
+		std::vector<Interval>& next = nextIntervals;
+		open.assign(1, Interval{ 0.0f, 1.0f, vec2(mx[0], my[0]), vec2(mx[1], my[1]) });
+		for (int depth = 0; !open.empty(); depth++) {
+			tm.resize(open.size()); mmx.resize(open.size()); mmy.resize(open.size());
+			for (size_t i = 0; i < open.size(); i++) tm[i] = 0.5f * (open[i].t0 + open[i].t1);
+			GreatCircleBatch(start, end, D, &tm[0], (int)tm.size(), &mmx[0], &mmy[0]);
+			for (size_t i = 0; i < open.size(); i++) {
+				const Interval& iv = open[i];
+				vec2 mm(mmx[i], mmy[i]);
+				vec2 chord = Unwrap(iv.m1, iv.m0.x) - iv.m0, off = Unwrap(mm, iv.m0.x) - iv.m0;
+				float len = length(chord);
+				float dist = len > 0.0f ? fabs(chord.x * off.y - chord.y * off.x) / len : length(off);
+				if (depth < maxDepth && ((iv.t1 - iv.t0) * D > maxAngle || dist > tol)) {
+					samples.push_back(std::make_pair(tm[i], mm));
+					next.push_back(Interval{ iv.t0, tm[i], iv.m0, mm });
+					next.push_back(Interval{ tm[i], iv.t1, mm, iv.m1 });
+				}
+			}
+			open.swap(next);
+			next.clear();
+		}
+		std::sort(samples.begin(), samples.end(), [](const std::pair<float, vec2>& a, const std::pair<float, vec2>& b) { return a.first < b.first; });
+		for (size_t i = 0; i < samples.size(); i++) Emit(samples[i].second);
+	}
 public:
 	std::vector<vec2> stations;
 	void addStation(const vec2& station) {
 		stations.push_back(station);
-		vtx.clear();
 	}
+	void addStations(const vec2* positions, size_t n) {
+		stations.insert(stations.end(), positions, positions + n);
+	}
+	//A görbe megengedett eltérése (pixel); csak az ezután hozzáadott szakaszokra hat
+	void SetTolerance(float pixels) { tolerance = pixels; }
+	//A még hiányzó szakaszok hozzáfűzése. A töröttvonal az utolsó állomással zárul; ezt a pontot
+	//a következő szakasz első pontja váltja fel.
 	void MakePath() {
-		if (stations.size() < 2) return;
-		for (size_t i = 0; i < stations.size() - 1; i++) {
-
-			vec3 start = MapToSphere(MercatorToMap(stations[i]));
-			vec3 end = MapToSphere(MercatorToMap(stations[i+1]));
-		
-			float D = acos(dot(start, end));
-			for (float t = 0.00f; t < 1.0f; t += 0.01f) {
-				vec3 spherePoint =  sin((1 - t) * D) * start / sin(D) + (sin(t * D) * end / sin(D));
-				vec2 mercatorPoint = MapToMercator(SphereToMap(spherePoint));
-				vtx.push_back(mercatorPoint);
-			}
-		
+		if (stations.size() < 2 || legs == stations.size() - 1) return;
+		if (legs > 0) Restore(beforeClose);
+		size_t first = vtx.size();
+		for (; legs < stations.size() - 1; legs++) {
+			vec3 start = MapToSphere(MercatorToMap(stations[legs]));
+			vec3 end = MapToSphere(MercatorToMap(stations[legs + 1]));
+			AppendArc(start, end);
 		}
-	
+		beforeClose = Save();
+		Emit(stations.back());
+		if (vtx.size() > first) MarkDirty(first, vtx.size() - first);
+		SyncGPU();
 	}
+	//Előre felbontott útvonal fájlba: fejléc, állomások, csúcsok, sávok. Az építés állapota is bekerül,
+	//így betöltés után az útvonal új állomásokkal folytatható.
+	bool SaveTessellated(const char* filename) {
+		PathFileHeader header;
+		memcpy(header.magic, "PTH1", 4);
+		header.stations = (uint32_t)stations.size();
+		header.vertices = (uint32_t)vtx.size();
+		header.strips = (uint32_t)stripFirst.size();
+		header.legs = (uint32_t)legs;
+		header.closeVertices = (uint32_t)beforeClose.vertices;
+		header.closeStrips = (uint32_t)beforeClose.strips;
+		header.closeLastCount = beforeClose.lastCount;
+		header.closeFlags = (beforeClose.open ? 1 : 0) | (beforeClose.hasLast ? 2 : 0);
+		header.closeLastX = beforeClose.last.x; header.closeLastY = beforeClose.last.y;
+		header.flags = (open ? 1 : 0) | (hasLast ? 2 : 0);
+		header.lastX = last.x; header.lastY = last.y;
+		FILE* file = fopen(filename, "wb");
+		if (!file) return false;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		if (ok && !stations.empty()) ok = fwrite(&stations[0], sizeof(vec2), stations.size(), file) == stations.size();
+		if (ok && !vtx.empty()) ok = fwrite(&vtx[0], sizeof(vec2), vtx.size(), file) == vtx.size();
+		if (ok && !stripFirst.empty()) ok = fwrite(&stripFirst[0], sizeof(int), stripFirst.size(), file) == stripFirst.size();
+		if (ok && !stripCount.empty()) ok = fwrite(&stripCount[0], sizeof(int), stripCount.size(), file) == stripCount.size();
+		return fclose(file) == 0 && ok;
+	}
+	//A fájl tartalma csak akkor kerül a helyére, ha minden index a tömbökön belül van: a sávok a csúcsokon belül,
+	//a záró állapot a sávokon és csúcsokon belül, a szakaszok az állomások között, és minden koordináta véges
+	//(az állomások és a csúcsok a fájlban egymás után vannak, egy ciklus nézi végig őket).
+	static bool ValidFile(const PathFileHeader& header, const vec2* pstations, const int* pfirst, const int* pcount) {
+		if (header.legs > 0 && header.legs >= header.stations) return false;
+		if (header.closeVertices > header.vertices || header.closeStrips > header.strips) return false;
+		if (header.closeLastCount < 0 || (header.closeStrips == 0 && header.closeLastCount != 0)) return false;
+		for (uint32_t i = 0; i < header.strips; i++) {
+			if (pfirst[i] < 0 || pcount[i] < 0 || uint64_t(pfirst[i]) + uint64_t(pcount[i]) > header.vertices) return false;
+		}
+		if (header.closeStrips > 0 && uint64_t(pfirst[header.closeStrips - 1]) + uint64_t(header.closeLastCount) > header.closeVertices) return false;
+		const float* coords = &pstations[0].x;
+		for (uint64_t i = 0; i < 2 * (uint64_t(header.stations) + header.vertices); i++) if (!std::isfinite(coords[i])) return false;
+		const float last[4] = { header.lastX, header.lastY, header.closeLastX, header.closeLastY };
+		for (float f : last) if (!std::isfinite(f)) return false;
+		return true;
+	}
+	//Betöltés a SaveTessellated fájljából: a fájl memóriába vetítve (mmap), a tömbök egy-egy másolással
+	//kerülnek a helyükre, és a csúcsok egyetlen feltöltéssel mennek a GPU-ra. Windows alatt sima olvasás.
+	//Hibás vagy csonka fájlnál false, és az útvonal változatlan marad.
+	bool LoadTessellated(const char* filename) {
+		std::vector<char> buffer;
+		const char* data = nullptr;
+		size_t size = 0;
+#ifndef _WIN32
+		int fd = ::open(filename, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		void* mapped = MAP_FAILED;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			size = (size_t)st.st_size;
+			mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		::close(fd);
+		if (mapped == MAP_FAILED) return false;
+		data = (const char*)mapped;
+#else
+		FILE* file = fopen(filename, "rb");
+		if (!file) return false;
+		fseek(file, 0, SEEK_END);
+		size = (size_t)ftell(file);
+		fseek(file, 0, SEEK_SET);
+		buffer.resize(size);
+		bool read = size > 0 && fread(&buffer[0], 1, size, file) == size;
+		fclose(file);
+		if (!read) return false;
+		data = &buffer[0];
+#endif
+		PathFileHeader header;
+		bool ok = size >= sizeof(header);
+		if (ok) {
+			memcpy(&header, data, sizeof(header));
+			uint64_t need = sizeof(header) + (uint64_t(header.stations) + header.vertices) * sizeof(vec2) + uint64_t(header.strips) * 2 * sizeof(int);
+			ok = memcmp(header.magic, "PTH1", 4) == 0 && size == need;
+		}
+		const vec2* pstations = (const vec2*)(data + sizeof(header));
+		const vec2* pvertices = ok ? pstations + header.stations : nullptr;
+		const int* pfirst = ok ? (const int*)(pvertices + header.vertices) : nullptr;
+		const int* pcount = ok ? pfirst + header.strips : nullptr;
+		if (ok) ok = ValidFile(header, pstations, pfirst, pcount);
+		if (ok) {
+			stations.assign(pstations, pstations + header.stations);
+			vtx.assign(pvertices, pvertices + header.vertices);
+			stripFirst.assign(pfirst, pfirst + header.strips);
+			stripCount.assign(pcount, pcount + header.strips);
+			legs = header.legs;
+			beforeClose.vertices = header.closeVertices;
+			beforeClose.strips = header.closeStrips;
+			beforeClose.lastCount = header.closeLastCount;
+			beforeClose.open = (header.closeFlags & 1) != 0; beforeClose.hasLast = (header.closeFlags & 2) != 0;
+			beforeClose.last = vec2(header.closeLastX, header.closeLastY);
+			open = (header.flags & 1) != 0; hasLast = (header.flags & 2) != 0;
+			last = vec2(header.lastX, header.lastY);
+		}
+#ifndef _WIN32
+		munmap((void*)data, size);
+#endif
+		if (!ok) return false;
+		MarkDirty(0, vtx.size());
+		SyncGPU();
+		return true;
+	}
+	const std::vector<int>& StripFirst() { return stripFirst; }
+	const std::vector<int>& StripCount() { return stripCount; }
+	//Az összes sáv egy hívással
 	void drawPath(GPUProgram* gpuProgram) {
-		if (this->Vtx().size() == 0) return;
-		updateGPU();
+		if (stripFirst.empty()) return;
 		gpuProgram->setUniform(false, "useTexture");
+		gpuProgram->setUniform(vec3(1.0f, 1.0f, 0.0f), "color");
 		glLineWidth(3.0f);
-		Draw(gpuProgram, GL_LINE_STRIP, vec3(1.0f, 1.0f, 0.0f));
+		Bind();
+		glMultiDrawArrays(GL_LINE_STRIP, &stripFirst[0], &stripCount[0], (int)stripFirst.size());
 	}
 };
 
 
 
+//Útvonalpontok tömeges betöltése fájlból az állomások és az útvonal végére.
+//Szöveges formátum: soronként "szélesség,hosszúság" fokban ('#'-tel kezdődő és nem számmal kezdődő sorok kimaradnak).
+//Bináris formátum: "WPT1", uint32 darabszám, majd darabonként float szélesség és hosszúság.
+//Mindkét formátumban a földrajzi tartományon kívüli pontok kimaradnak (Skipped).
+//A fájl rögzített méretű darabokban jön be, a pontok legfeljebb batchSize-os kötegekben gyűlnek, a kötegek
+//Mercator-átalakítása több szálon fut. GPU-ra a végén egyszer tölt fel.
+class RouteImporter {
+	static constexpr size_t chunkSize = 1 << 20;
+	static constexpr size_t batchSize = 1 << 16;
+	Station* station;
+	Path* path;
+	std::vector<float> lat, lon, mx, my;
+	std::vector<vec2> points;
+	size_t total = 0, skipped = 0;
+
+	//A tartományon kívüli (vagy nem szám) koordinátájú pontok kimaradnak, a számukat a Skipped adja
+	void Add(float la, float lo) {
+		if (!(la >= -90.0f && la <= 90.0f && lo >= -180.0f && lo <= 180.0f)) { skipped++; return; }
+		lat.push_back(la);
+		lon.push_back(lo);
+		if (lat.size() == batchSize) Flush();
+	}
+	void Flush() {
+		size_t n = lat.size();
+		if (n == 0) return;
+		mx.resize(n); my.resize(n);
+		int nthreads = n < 8192 ? 1 : std::max(1, (int)std::thread::hardware_concurrency());
+		std::vector<std::thread> workers;
+		for (int w = 1; w < nthreads; w++) {
+			size_t begin = n * w / nthreads, end = n * (w + 1) / nthreads;
+			workers.push_back(std::thread(MapToMercatorBatch, &lat[begin], &lon[begin], (int)(end - begin), &mx[begin], &my[begin]));
+		}
+		MapToMercatorBatch(&lat[0], &lon[0], (int)(n / nthreads), &mx[0], &my[0]);
+		for (auto& worker : workers) worker.join();
+		points.resize(n);
+		for (size_t i = 0; i < n; i++) points[i] = vec2(mx[i], my[i]);
+		if (station) station->addStations(&points[0], n);
+		if (path) path->addStations(&points[0], n);
+		total += n;
+		lat.clear(); lon.clear();
+	}
+	void ReadCSV(FILE* file) {
+		std::vector<char> buffer(chunkSize + 1);
+		size_t kept = 0; //az előző darab végén maradt befejezetlen sor
+		for (;;) {
+			size_t got = fread(&buffer[kept], 1, chunkSize - kept, file);
+			size_t end = kept + got;
+			bool last = got == 0;
+			if (last && kept == 0) break;
+			if (last) buffer[end++] = '\n';
+			size_t lineStart = 0;
+			for (size_t i = 0; i < end; i++) {
+				if (buffer[i] != '\n') continue;
+				buffer[i] = 0;
+				ParseLine(&buffer[lineStart]);
+				lineStart = i + 1;
+			}
+			kept = end - lineStart;
+			//egy darabnál hosszabb sort eldobunk, hogy a puffer ne nőjön
+			if (kept == chunkSize) kept = 0;
+			memmove(&buffer[0], &buffer[lineStart], kept);
+			if (last) break;
+		}
+	}
+	void ParseLine(char* line) {
+		while (*line == ' ' || *line == '\t') line++;
+		if (!(*line == '-' || *line == '+' || *line == '.' || (*line >= '0' && *line <= '9'))) return;
+		char* next;
+		float la = strtof(line, &next);
+		if (next == line) return;
+		while (*next == ',' || *next == ';' || *next == ' ' || *next == '\t') next++;
+		char* rest;
+		float lo = strtof(next, &rest);
+		if (rest == next) return;
+		Add(la, lo);
+	}
+	bool ReadBinary(FILE* file) {
+		uint32_t count;
+		if (fread(&count, sizeof(count), 1, file) != 1) return false;
+		std::vector<float> buffer(2 * batchSize);
+		while (count > 0) {
+			size_t n = count < batchSize ? count : batchSize;
+			if (fread(&buffer[0], 2 * sizeof(float), n, file) != n) return false;
+			for (size_t i = 0; i < n; i++) Add(buffer[2 * i], buffer[2 * i + 1]);
+			count -= (uint32_t)n;
+		}
+		return true;
+	}
+public:
+	RouteImporter(Station* pStation, Path* pPath) : station(pStation), path(pPath) {}
+	//A beolvasott pontok száma, hibánál a hibáig beolvasottaké
+	size_t Load(const char* filename) {
+		FILE* file = fopen(filename, "rb");
+		if (!file) return 0;
+		char magic[4];
+		bool binary = fread(magic, 1, 4, file) == 4 && memcmp(magic, "WPT1", 4) == 0;
+		if (!binary) fseek(file, 0, SEEK_SET);
+		if (binary) ReadBinary(file);
+		else ReadCSV(file);
+		fclose(file);
+		Flush();
+		if (station) station->SyncGPU();
+		if (path) path->MakePath();
+		return total;
+	}
+	//A szélesség [-90, 90], a hosszúság [-180, 180] fokos tartományán kívül eső, kihagyott pontok száma
+	size_t Skipped() { return skipped; }
+};
+
+
 class GreenTriangleApp : public glApp {
 
 	GPUProgram* gpuProgram;	   
@@ -244,7 +822,7 @@ class GreenTriangleApp : public glApp {
 public:
 	GreenTriangleApp() : glApp("Green triangle") { }
 
-	// Inicializci, 
+	// Inicializáció, 
 	void onInitialization() {
 		map = new Map();
 		station = new Station();
@@ -252,10 +830,10 @@ public:
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 	}
 
-	// Ablak jrarajzols
+	// Ablak újrarajzolás
 	void onDisplay() {
-		glClearColor(0, 0, 0, 0);     // httr szn
-		glClear(GL_COLOR_BUFFER_BIT); // rasztertr trls
+		glClearColor(0, 0, 0, 0);     // háttér szín
+		glClear(GL_COLOR_BUFFER_BIT); // rasztertár törlés
 		glViewport(0, 0, winWidth, winHeight);
 		map->Draw(gpuProgram);
 		path->drawPath(gpuProgram);
@@ -264,6 +842,7 @@ public:
 	void onMousePressed(MouseButton but, int pX, int pY) {
 		vec2 normalPos = ScreenToNDC(vec2(pX, pY));
 		station->addStation(normalPos);
+		LOG(LOG_DEBUG, LOG_PATH, "Station: %f, %f added", normalPos.x, normalPos.y);
 		//printf("x: %f, y: %f\n", normalPos.x, normalPos.y);
 		/*vec2 normalPos = vec2(-0.65f, 0.33f);
 		printf("x: %f, y: %f\n", normalPos.x, normalPos.y);
@@ -296,6 +875,36 @@ public:
 		refreshScreen();
 	
 	}
+	//Útvonal importálása (i: szöveges, b: bináris), az előre felbontott útvonal mentése (w) és betöltése (o)
+	void onKeyboard(int key) {
+		if (key == 'i' || key == 'b') {
+			const char* filename = key == 'i' ? "terkep_route.csv" : "terkep_route.bin";
+			auto begin = std::chrono::steady_clock::now();
+			RouteImporter importer(station, path);
+			size_t n = importer.Load(filename);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			LOG(LOG_INFO, LOG_PATH, "%zu waypoints imported from %s in %.1f ms", n, filename, ms);
+			if (importer.Skipped() > 0) LOG(LOG_WARN, LOG_PATH, "%zu out-of-range waypoints skipped in %s", importer.Skipped(), filename);
+			refreshScreen();
+		}
+		if (key == 'w') {
+			if (path->SaveTessellated("terkep_path.bin")) LOG(LOG_INFO, LOG_PATH, "Path saved to terkep_path.bin");
+			else LOG(LOG_ERROR, LOG_PATH, "Cannot write terkep_path.bin");
+		}
+		if (key == 'o') {
+			auto begin = std::chrono::steady_clock::now();
+			if (path->LoadTessellated("terkep_path.bin")) {
+				delete station;
+				station = new Station();
+				station->addStations(path->stations.data(), path->stations.size());
+				station->SyncGPU();
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+				LOG(LOG_INFO, LOG_PATH, "Path loaded from terkep_path.bin in %.1f ms", ms);
+				refreshScreen();
+			}
+			else LOG(LOG_ERROR, LOG_PATH, "Cannot read terkep_path.bin");
+		}
+	}
 	void keyboard(unsigned char key, int x, int y) {
 		if (key == 'n') {
 			currentHour++;
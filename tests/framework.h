@@ -0,0 +1,187 @@
+//=============================================================================================
+// A framework.h csonkja a GPU nélküli tesztekhez: a vektorok és mátrixok a framework szerint (oszlopvektorok,
+// MVP = P * V * M), a GL függvények nem csinálnak semmit, csak a hívásaikat számolják (GLCalls(), a pufferfeltöltéseket
+// külön is: GLUploads()).
+//=============================================================================================
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#include <math.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+using std::abs;
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//Az eddigi GL hívások száma
+inline long& GLCalls() { static long calls = 0; return calls; }
+//Az eddigi glBufferData és glBufferSubData hívások száma
+inline long& GLUploads() { static long uploads = 0; return uploads; }
+
+enum {
+	GL_ARRAY_BUFFER = 1, GL_DYNAMIC_DRAW, GL_STATIC_DRAW, GL_FLOAT, GL_FALSE, GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP,
+	GL_TRIANGLE_FAN, GL_TRIANGLES, GL_COLOR_BUFFER_BIT, GL_TEXTURE_2D, GL_RGB, GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER,
+	GL_NEAREST, GL_LINEAR, GL_TEXTURE0
+};
+inline void glGenVertexArrays(int, unsigned int* vao) { GLCalls()++; *vao = 1; }
+inline void glGenBuffers(int n, unsigned int* vbo) { GLCalls()++; for (int i = 0; i < n; i++) vbo[i] = 1; }
+inline void glBindVertexArray(unsigned int) { GLCalls()++; }
+inline void glBindBuffer(int, unsigned int) { GLCalls()++; }
+inline void glEnableVertexAttribArray(int) { GLCalls()++; }
+inline void glVertexAttribPointer(int, int, int, int, int, const void*) { GLCalls()++; }
+inline void glVertexAttribDivisor(int, int) { GLCalls()++; }
+inline void glBufferData(int, size_t, const void*, int) { GLCalls()++; GLUploads()++; }
+inline void glBufferSubData(int, size_t, size_t, const void*) { GLCalls()++; GLUploads()++; }
+inline void glDrawArrays(int, int, int) { GLCalls()++; }
+inline void glMultiDrawArrays(int, const int*, const int*, int) { GLCalls()++; }
+inline void glDrawArraysInstanced(int, int, int, int) { GLCalls()++; }
+inline void glDeleteBuffers(int, const unsigned int*) { GLCalls()++; }
+inline void glDeleteVertexArrays(int, const unsigned int*) { GLCalls()++; }
+inline void glPointSize(float) { GLCalls()++; }
+inline void glLineWidth(float) { GLCalls()++; }
+inline void glClearColor(float, float, float, float) { GLCalls()++; }
+inline void glClear(int) { GLCalls()++; }
+inline void glViewport(int, int, int, int) { GLCalls()++; }
+inline void glGenTextures(int, unsigned int* texture) { GLCalls()++; *texture = 1; }
+inline void glBindTexture(int, unsigned int) { GLCalls()++; }
+inline void glTexImage2D(int, int, int, int, int, int, int, int, const void*) { GLCalls()++; }
+inline void glTexParameteri(int, int, int) { GLCalls()++; }
+inline void glActiveTexture(int) { GLCalls()++; }
+inline void glDeleteTextures(int, const unsigned int*) { GLCalls()++; }
+
+struct vec2 {
+	float x, y;
+	vec2(float x0 = 0, float y0 = 0) : x(x0), y(y0) {}
+	vec2 operator*(float a) const { return vec2(x * a, y * a); }
+	vec2 operator/(float a) const { return vec2(x / a, y / a); }
+	vec2 operator+(const vec2& v) const { return vec2(x + v.x, y + v.y); }
+	vec2 operator-(const vec2& v) const { return vec2(x - v.x, y - v.y); }
+	vec2 operator*(const vec2& v) const { return vec2(x * v.x, y * v.y); }
+	vec2 operator-() const { return vec2(-x, -y); }
+	void operator+=(const vec2& v) { x += v.x; y += v.y; }
+};
+inline float dot(const vec2& a, const vec2& b) { return a.x * b.x + a.y * b.y; }
+inline float length(const vec2& v) { return sqrtf(dot(v, v)); }
+inline vec2 normalize(const vec2& v) { return v * (1 / length(v)); }
+inline vec2 operator*(float a, const vec2& v) { return v * a; }
+
+struct vec3 {
+	float x, y, z;
+	vec3(float x0 = 0, float y0 = 0, float z0 = 0) : x(x0), y(y0), z(z0) {}
+	vec3(vec2 v) : x(v.x), y(v.y), z(0) {}
+	vec3 operator*(float a) const { return vec3(x * a, y * a, z * a); }
+	vec3 operator/(float a) const { return vec3(x / a, y / a, z / a); }
+	vec3 operator+(const vec3& v) const { return vec3(x + v.x, y + v.y, z + v.z); }
+	vec3 operator-(const vec3& v) const { return vec3(x - v.x, y - v.y, z - v.z); }
+	vec3 operator*(const vec3& v) const { return vec3(x * v.x, y * v.y, z * v.z); }
+	vec3 operator-() const { return vec3(-x, -y, -z); }
+	void operator+=(const vec3& v) { x += v.x; y += v.y; z += v.z; }
+	void operator-=(const vec3& v) { x -= v.x; y -= v.y; z -= v.z; }
+};
+inline float dot(const vec3& a, const vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float length(const vec3& v) { return sqrtf(dot(v, v)); }
+inline vec3 normalize(const vec3& v) { return v * (1 / length(v)); }
+inline vec3 operator*(float a, const vec3& v) { return v * a; }
+inline vec3 cross(const vec3& a, const vec3& b) { return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+
+struct vec4 {
+	float x, y, z, w;
+	vec4(float x0 = 0, float y0 = 0, float z0 = 0, float w0 = 0) : x(x0), y(y0), z(z0), w(w0) {}
+	float& operator[](int j) { return *(&x + j); }
+	float operator[](int j) const { return *(&x + j); }
+	vec4 operator*(float a) const { return vec4(x * a, y * a, z * a, w * a); }
+	vec4 operator+(const vec4& v) const { return vec4(x + v.x, y + v.y, z + v.z, w + v.w); }
+};
+
+//Oszlopokban tárolt 4x4-es mátrix, m[i] az i. oszlop
+struct mat4 {
+	vec4 cols[4];
+	mat4(float d = 1) { cols[0] = vec4(d, 0, 0, 0); cols[1] = vec4(0, d, 0, 0); cols[2] = vec4(0, 0, d, 0); cols[3] = vec4(0, 0, 0, d); }
+	vec4& operator[](int i) { return cols[i]; }
+	vec4 operator[](int i) const { return cols[i]; }
+};
+inline vec4 operator*(const mat4& m, const vec4& v) { return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * v.w; }
+inline mat4 operator*(const mat4& a, const mat4& b) { mat4 r; for (int i = 0; i < 4; i++) r[i] = a * b[i]; return r; }
+inline mat4 translate(vec3 t) { mat4 m; m[3] = vec4(t.x, t.y, t.z, 1); return m; }
+inline mat4 scale(vec3 s) { mat4 m; m[0].x = s.x; m[1].y = s.y; m[2].z = s.z; return m; }
+//A z tengely körüli forgatás (a programok csak ezt használják)
+inline mat4 rotate(float angle, vec3) {
+	float c = cosf(angle), s = sinf(angle);
+	mat4 m;
+	m[0] = vec4(c, s, 0, 0);
+	m[1] = vec4(-s, c, 0, 0);
+	return m;
+}
+//Inverz Gauss-Jordan eliminációval, részleges főelem-kiválasztással
+inline mat4 inverse(const mat4& m) {
+	double a[4][8];
+	for (int i = 0; i < 4; i++) for (int j = 0; j < 4; j++) { a[i][j] = m[j][i]; a[i][4 + j] = i == j; }
+	for (int c = 0; c < 4; c++) {
+		int p = c;
+		for (int r = c + 1; r < 4; r++) if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+		for (int j = 0; j < 8; j++) std::swap(a[c][j], a[p][j]);
+		double d = a[c][c];
+		for (int j = 0; j < 8; j++) a[c][j] /= d;
+		for (int r = 0; r < 4; r++) {
+			if (r == c) continue;
+			double f = a[r][c];
+			for (int j = 0; j < 8; j++) a[r][j] -= f * a[c][j];
+		}
+	}
+	mat4 r;
+	for (int i = 0; i < 4; i++) for (int j = 0; j < 4; j++) r[j][i] = (float)a[i][4 + j];
+	return r;
+}
+
+class GPUProgram {
+public:
+	GPUProgram(const char*, const char*) {}
+	template<class T> void setUniform(T, const std::string&) {}
+};
+
+template<class T> class Geometry {
+	unsigned int vao, vbo;
+protected:
+	std::vector<T> vtx;
+public:
+	Geometry() {
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, sizeof(T) / sizeof(float), GL_FLOAT, GL_FALSE, 0, NULL);
+	}
+	std::vector<T>& Vtx() { return vtx; }
+	void updateGPU() { Bind(); glBufferData(GL_ARRAY_BUFFER, vtx.size() * sizeof(T), &vtx[0], GL_DYNAMIC_DRAW); }
+	void Bind() { glBindVertexArray(vao); glBindBuffer(GL_ARRAY_BUFFER, vbo); }
+	virtual void Draw(GPUProgram* prog, int type, vec3 color) {
+		if (vtx.size() > 0) {
+			prog->setUniform(color, "color");
+			glBindVertexArray(vao);
+			glDrawArrays(type, 0, (int)vtx.size());
+		}
+	}
+	virtual ~Geometry() { glDeleteBuffers(1, &vbo); glDeleteVertexArrays(1, &vao); }
+};
+
+enum MouseButton { MOUSE_LEFT, MOUSE_MIDDLE, MOUSE_RIGHT };
+
+class glApp {
+public:
+	glApp(const char*) {}
+	virtual void onInitialization() {}
+	virtual void onDisplay() {}
+	virtual void onKeyboard(int) {}
+	virtual void onKeyboardUp(int) {}
+	virtual void onMousePressed(MouseButton, int, int) {}
+	virtual void onMouseReleased(MouseButton, int, int) {}
+	virtual void onMouseMotion(int, int) {}
+	virtual void onTimeElapsed(float, float) {}
+	void refreshScreen() {}
+	virtual ~glApp() {}
+};
@@ -0,0 +1,822 @@
+//=============================================================================================
+// geometria.cpp tesztjei és mérései GL nélkül (a csonk framework.h-val). "bench" argumentummal a mérések is futnak.
+//=============================================================================================
+#include "../geometria.cpp"
+#include <random>
+#include <string>
+#include <unistd.h>
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static double Since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+//n véletlen egyenes, mindegyik az ablak két véletlen pontján át
+static void RandomLines(LineCollection& lines, int n, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	for (int i = 0; i < n; i++) {
+		vec3 a(u(rng), u(rng), 1.0f), b(u(rng), u(rng), 1.0f);
+		lines.AddNew(Line(a, b));
+	}
+}
+//Az összes metszéspont két egymásba ágyazott ciklussal, egy szálon (a mérések alapvonala)
+static std::vector<vec3> IntersectAllPlain(LineCollection& lines) {
+	std::vector<vec3> crosspoints;
+	for (size_t i = 0; i < lines.Count(); i++) {
+		for (size_t j = i + 1; j < lines.Count(); j++) {
+			vec3 p;
+			if (!lines.Get((int)i).Intersect(lines.Get((int)j), p)) continue;
+			if (p.x >= -1.0f && p.x <= 1.0f && p.y >= -1.0f && p.y <= 1.0f) crosspoints.push_back(p);
+		}
+	}
+	return crosspoints;
+}
+
+//A szűrés előtti metszéspont: csak a float képlet, párhuzamos egyeneseknél inf/NaN
+static vec3 PlainCrossPoint(Line& l1, Line& l2) {
+	float x = (l2.getC() * l1.getB() - l1.getC() * l2.getB()) / (l1.getA() * l2.getB() - l2.getA() * l1.getB());
+	float y = (l1.getC() * l2.getA() - l2.getC() * l1.getA()) / (l2.getB() * l1.getA() - l1.getB() * l2.getA());
+	return vec3(x, y, 1.0f);
+}
+//Ugyanez SoA tömbökön, a LineCoeffs::CrossPoints szerkezetével (AVX2 mag, skalár maradék), szűrő nélkül
+static void PlainCrossPoints(const float* A, const float* B, const float* C, int l, int first, int n, float* x, float* y) {
+	int k = 0;
+#ifdef __AVX2__
+	__m256 a1 = _mm256_set1_ps(A[l]), b1 = _mm256_set1_ps(B[l]), c1 = _mm256_set1_ps(C[l]);
+	for (; k + 8 <= n; k += 8) {
+		__m256 a2 = _mm256_loadu_ps(A + first + k), b2 = _mm256_loadu_ps(B + first + k), c2 = _mm256_loadu_ps(C + first + k);
+		__m256 px = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(c2, b1), _mm256_mul_ps(c1, b2)),
+			_mm256_sub_ps(_mm256_mul_ps(a1, b2), _mm256_mul_ps(a2, b1)));
+		__m256 py = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(c1, a2), _mm256_mul_ps(c2, a1)),
+			_mm256_sub_ps(_mm256_mul_ps(b2, a1), _mm256_mul_ps(b1, a2)));
+		_mm256_storeu_ps(x + k, px);
+		_mm256_storeu_ps(y + k, py);
+	}
+#endif
+	for (; k < n; k++) {
+		int j = first + k;
+		x[k] = (C[j] * B[l] - C[l] * B[j]) / (A[l] * B[j] - A[j] * B[l]);
+		y[k] = (C[l] * A[j] - C[j] * A[l]) / (B[j] * A[l] - B[l] * A[j]);
+	}
+}
+//Az ablak véletlen pontjai, amelyek az origótól legalább rmin távolságra vannak
+static vec3 RandomPoint(std::mt19937& rng, float rmin) {
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	for (;;) {
+		vec3 p(u(rng), u(rng), 1.0f);
+		if (p.x * p.x + p.y * p.y >= rmin * rmin) return p;
+	}
+}
+//Egyenes, amely az origótól legalább rmin távolságra halad
+static Line FarLine(std::mt19937& rng, float rmin) {
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI)), offset(rmin, 1.4f);
+	float th = angle(rng), rho = offset(rng);
+	vec3 p(rho * cos(th), rho * sin(th), 1.0f), d(-sin(th) * 0.1f, cos(th) * 0.1f, 0.0f);
+	return Line(p - d, p + d);
+}
+//A régi, lineáris keresések: az első találat a felvétel sorrendjében
+static int SelectLineLinear(LineCollection& lines, const vec3& mouse) {
+	for (size_t i = 0; i < lines.Count(); i++) if (lines.Get((int)i).onLine(mouse)) return (int)i;
+	return -1;
+}
+static int SelectPointLinear(PointCollection& points, const vec3& mouse) {
+	std::vector<vec3>& vtx = points.Vtx();
+	for (size_t i = 0; i < vtx.size(); i++) {
+		float dx = mouse.x - vtx[i].x, dy = mouse.y - vtx[i].y, dz = mouse.z - vtx[i].z;
+		if (sqrt(dx * dx + dy * dy + dz * dz) <= 0.019f) return (int)i;
+	}
+	return -1;
+}
+static int PointId(PointCollection& points, const vec3& p) {
+	if (p.x == 0.0f && p.y == 0.0f && p.z == 0.0f) return -1;
+	std::vector<vec3>& vtx = points.Vtx();
+	for (size_t i = 0; i < vtx.size(); i++) if (vtx[i].x == p.x && vtx[i].y == p.y && vtx[i].z == p.z) return (int)i;
+	return -2;
+}
+
+//SelectLine és SelectPoint ugyanazt adja, mint a lineáris keresés, eltolások és visszavonások után is
+static void TestSelect() {
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	LineCollection lines;
+	//a távoli egyenesek után a véletlenek már a sorban nézett első scanFirst fölé esnek, az origó körüli
+	//kattintásokat csak az index találja meg
+	for (int i = 0; i < 5000; i++) lines.AddNew(FarLine(rng, 0.5f));
+	RandomLines(lines, 300, 4);
+	lines.AddNew(Line(vec3(-0.5f, 0.25f, 1.0f), vec3(0.5f, 0.25f, 1.0f))); //vízszintes (A = 0)
+	lines.AddNew(Line(vec3(0.25f, -0.5f, 1.0f), vec3(0.25f, 0.5f, 1.0f))); //függőleges (B = 0)
+	int differ = 0, hits = 0;
+	for (int q = 0; q < 5000; q++) {
+		vec3 mouse = q % 2 ? vec3(u(rng), u(rng), 1.0f) : RandomPoint(rng, 0.0f) * 0.3f + vec3(0.0f, 0.0f, 0.7f);
+		int id = lines.SelectLine(mouse);
+		differ += id != SelectLineLinear(lines, mouse);
+		hits += id >= 0;
+		if (q % 10 == 0) {
+			int moved = std::uniform_int_distribution<int>(0, (int)lines.Count() - 1)(rng);
+			lines.Translate(moved, vec3(u(rng), u(rng), 1.0f));
+		}
+		if (q % 500 == 0) lines.RemoveLast();
+	}
+	CHECK(differ == 0);
+	CHECK(hits > 0 && hits < 5000);
+	CHECK(lines.SelectLine(vec3(0.0f, 0.25f, 1.0f)) == SelectLineLinear(lines, vec3(0.0f, 0.25f, 1.0f)));
+
+	PointCollection points;
+	for (int i = 0; i < 20000; i++) points.AddNew(vec3(u(rng), u(rng), 1.0f));
+	differ = 0;
+	for (int q = 0; q < 5000; q++) {
+		vec3 mouse(u(rng), u(rng), 1.0f);
+		differ += PointId(points, points.SelectPoint(mouse)) != SelectPointLinear(points, mouse);
+		if (q % 100 == 0) points.RemoveLast();
+	}
+	CHECK(differ == 0);
+}
+
+//Kattintásonkénti idő a SelectLine/SelectPoint és a lineáris keresés szerint: véletlen kattintások, illetve üres
+//területre (az egyenesek és pontok az origótól 0.5-nél messzebb, a kattintások 0.4-en belül) eső kattintások.
+//Sűrű jelenetben a SelectLine a sorban nézett elején talál, üres területen az index dönt.
+static void BenchSelect() {
+	printf("\nPicking, us per click: SelectLine/SelectPoint vs linear scan (random clicks / clicks on empty area)\n");
+	printf("%10s %12s %12s %12s %12s\n", "primitives", "line select", "line linear", "point index", "point linear");
+	for (int n : { 1000, 100000, 1000000 }) {
+		for (int empty = 0; empty < 2; empty++) {
+			std::mt19937 rng(5 + empty);
+			std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+			LineCollection lines;
+			PointCollection points;
+			for (int i = 0; i < n; i++) {
+				if (empty) lines.AddNew(FarLine(rng, 0.5f));
+				else lines.AddNew(Line(vec3(u(rng), u(rng), 1.0f), vec3(u(rng), u(rng), 1.0f)));
+				points.AddNew(RandomPoint(rng, empty ? 0.5f : 0.0f));
+			}
+			std::vector<vec3> clicks(n >= 1000000 ? 200 : 2000);
+			for (vec3& click : clicks) click = empty ? RandomPoint(rng, 0.0f) * 0.4f + vec3(0.0f, 0.0f, 0.6f) : vec3(u(rng), u(rng), 1.0f);
+			double t[4];
+			int check = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (const vec3& click : clicks) check += lines.SelectLine(click);
+			t[0] = Since(start);
+			start = std::chrono::steady_clock::now();
+			for (const vec3& click : clicks) check -= SelectLineLinear(lines, click);
+			t[1] = Since(start);
+			CHECK(check == 0);
+			start = std::chrono::steady_clock::now();
+			for (const vec3& click : clicks) check += (int)points.SelectPoint(click).x;
+			t[2] = Since(start);
+			start = std::chrono::steady_clock::now();
+			for (const vec3& click : clicks) check += SelectPointLinear(points, click);
+			t[3] = Since(start);
+			printf("%10d %12.2f %12.2f %12.2f %12.2f%s\n", n, t[0] / clicks.size() * 1e6, t[1] / clicks.size() * 1e6,
+				t[2] / clicks.size() * 1e6, t[3] / clicks.size() * 1e6, empty ? "  (empty area)" : "");
+		}
+	}
+}
+
+//Két azonos egyenes közül csak a kijelölt mozdul: a hanyadik régen az elsőt találta meg, bármelyiket húztuk
+static void TestDragDuplicates() {
+	LineCollection lines;
+	PointCollection points;
+	Journal journal(&points, &lines);
+	CountingUploader uploader;
+	lines.SetUploader(&uploader);
+	Line line(vec3(-0.5f, 0.0f, 1.0f), vec3(0.5f, 0.0f, 1.0f));
+	lines.AddNew(Line(vec3(-0.5f, 0.5f, 1.0f), vec3(0.5f, 0.6f, 1.0f)));
+	lines.AddNew(line);
+	lines.AddNew(line);
+	lines.SyncGPU();
+	vec3 p1 = lines.Vtx()[2], p2 = lines.Vtx()[3];
+	CHECK(lines.SelectLine(vec3(0.0f, 0.0f, 1.0f)) == 1);
+
+	//a második példányt húzzuk (például egy korábbi kijelölésből), az első a helyén marad
+	vec3 from = (lines.Get(2).getNormalP1() + lines.Get(2).getNormalP2()) / 2.0f;
+	for (int step = 1; step <= 10; step++) {
+		vec3 mouse(0.0f, -0.05f * step, 1.0f);
+		journal.Translate(2, from, mouse);
+		lines.Translate(2, mouse);
+		lines.SyncGPU();
+	}
+	journal.Close();
+	CHECK(lines.Vtx()[2].x == p1.x && lines.Vtx()[2].y == p1.y && lines.Vtx()[3].x == p2.x && lines.Vtx()[3].y == p2.y);
+	CHECK(fabs(lines.Vtx()[4].y + 0.5f) < 1e-5f && fabs(lines.Vtx()[5].y + 0.5f) < 1e-5f);
+	CHECK(lines.SelectLine(vec3(0.0f, 0.0f, 1.0f)) == 1);
+	CHECK(lines.SelectLine(vec3(0.0f, -0.5f, 1.0f)) == 2);
+	CHECK(uploader.uploads == 11 && uploader.uploaded == 6 * sizeof(vec3) + 10 * 2 * sizeof(vec3));
+
+	//visszavonás után újra fedik egymást, és az első azonosítójú a találat
+	CHECK(journal.Undo());
+	CHECK(lines.SelectLine(vec3(0.0f, 0.0f, 1.0f)) == 1);
+	CHECK(lines.SelectLine(vec3(0.0f, -0.5f, 1.0f)) == -1);
+	CHECK(fabs(lines.Vtx()[4].y - p1.y) < 1e-5f && fabs(lines.Vtx()[5].y - p2.y) < 1e-5f);
+}
+
+//Egy húzási lépés ideje (az onMouseMotion munkája: napló, eltolás, feltöltés) a jelenet méretének függvényében
+//motions mozgatás n véletlen egyenes között, mozgatásonként a feltöltéssel; a mozgatásonkénti idő másodpercben.
+//Ha sync nem NULL, minden mozgatás szinkron printf-fel oda is ír, mint a napló előtt.
+static double DragMotions(int n, int motions, FILE* sync) {
+	LineCollection lines;
+	PointCollection points;
+	Journal journal(&points, &lines);
+	CountingUploader uploader;
+	lines.SetUploader(&uploader);
+	RandomLines(lines, n, 6);
+	lines.SyncGPU();
+	auto start = std::chrono::steady_clock::now();
+	for (int k = 0; k < motions; k++) {
+		//egy húzás 100 mozgatás 2 pixelenként az ablakon át, utána a következő véletlen egyenes jön
+		if (k % 100 == 0) journal.Close();
+		int id = k / 100 * 7919 % n;
+		vec3 mouse(-0.66f + (k % 100) * 2.0f / 150.0f, 0.3f, 1.0f);
+		Line& line = lines.Get(id);
+		journal.Translate(id, (line.getNormalP1() + line.getNormalP2()) / 2.0f, mouse);
+		lines.Translate(id, mouse);
+		if (sync) fprintf(sync, "%fx+%fy+%fc\n", line.getA(), line.getB(), line.getC());
+		lines.SyncGPU();
+	}
+	double t = Since(start);
+	CHECK(uploader.uploads == (size_t)motions + 1);
+	return t / motions;
+}
+static void BenchDrag() {
+	printf("\nDragging, us per motion event\n");
+	printf("%8s %12s\n", "lines", "us/motion");
+	for (int n : { 1000, 10000, 100000, 1000000 }) printf("%8d %12.3f\n", n, DragMotions(n, 20000, nullptr) * 1e6);
+}
+//Húzás a napló különböző beállításaival (a Line::Translate debug/drag üzenete), a kimenet /dev/null, hogy a terminál
+//ne számítson; összevetve a régi szinkron printf-fel
+static void BenchDragLogging() {
+	FILE* null = fopen("/dev/null", "w");
+	if (!null) return;
+	printf("\nDragging 10000 lines, us per motion event, by logging setting\n");
+	printf("%28s %12s\n", "logging", "us/motion");
+	eventLog().SetOutput(null);
+	struct { const char* name; LogLevel level; unsigned sampling; bool sync; } settings[] = {
+		{ "off", LOG_OFF, 1, false }, { "info (drag filtered out)", LOG_INFO, 1, false }, { "debug, 1 in 100 sampled", LOG_DEBUG, 100, false },
+		{ "debug, every message", LOG_DEBUG, 1, false }, { "synchronous printf", LOG_OFF, 1, true },
+	};
+	for (auto& setting : settings) {
+		eventLog().SetLevel(setting.level);
+		eventLog().SetSampling(LOG_DRAG, setting.sampling);
+		printf("%28s %12.3f\n", setting.name, DragMotions(10000, 20000, setting.sync ? null : nullptr) * 1e6);
+		fflush(stdout);
+	}
+	eventLog().SetLevel(LOG_OFF);
+	eventLog().SetSampling(LOG_DRAG, 1);
+	eventLog().SetOutput(stdout);
+	fclose(null);
+}
+
+//A visszajátszás a CountingUploaderrel egyetlen GL hívást sem tesz; csak a végén, a valódi pufferre
+//visszaállva tölt fel egyszer gyűjteményenként (kötés, lefoglalás, feltöltés: 4 hívás)
+static void TestReplayWithoutGL() {
+	const char* filename = "geometria_replay_test.txt";
+	FILE* file = fopen(filename, "w");
+	fprintf(file, "# pontok, egyenesek, majd egy egyenes húzása\nk p\n");
+	for (int i = 0; i < 50; i++) fprintf(file, "p %d %d\n", 20 + 11 * i, 40 + 7 * i);
+	fprintf(file, "k l\n");
+	for (int i = 0; i < 50; i++) fprintf(file, "p %d %d\np %d %d\n", 20 + 11 * i, 40 + 7 * i, 580 - 3 * i, 500 - 9 * i);
+	fprintf(file, "k m\np 20 40\n");
+	for (int i = 0; i < 100; i++) fprintf(file, "m %d %d\n", 20 + i, 40 + 2 * i);
+	fprintf(file, "r 120 240\nk z\nk y\n");
+	fclose(file);
+
+	GreenTriangleApp replayApp;
+	replayApp.onInitialization();
+	long before = GLCalls();
+	replayApp.Replay(filename);
+	CHECK(GLCalls() - before == 8);
+	remove(filename);
+}
+
+static void WriteFile(const char* filename, const void* data, size_t bytes) {
+	FILE* file = fopen(filename, "wb");
+	fwrite(data, 1, bytes, file);
+	fclose(file);
+}
+static std::vector<char> ReadFile(const char* filename) {
+	std::vector<char> data;
+	FILE* file = fopen(filename, "rb");
+	if (!file) return data;
+	for (int c = fgetc(file); c != EOF; c = fgetc(file)) data.push_back((char)c);
+	fclose(file);
+	return data;
+}
+
+//Mentés és visszatöltés, majd hibás fájlok: egyik sem dobhat kivételt, és nem hagyhat félig betöltött jelenetet
+static void TestScene() {
+	const char* filename = "geometria_scene_test.bin";
+	PointCollection points;
+	LineCollection lines;
+	std::mt19937 rng(8);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	for (int i = 0; i < 100; i++) points.AddNew(vec3(u(rng), u(rng), 1.0f));
+	RandomLines(lines, 50, 9);
+	CHECK(SaveScene(filename, &points, &lines));
+	PointCollection loadedPoints;
+	LineCollection loadedLines;
+	CHECK(LoadScene(filename, &loadedPoints, &loadedLines));
+	CHECK(loadedPoints.Vtx().size() == 100 && loadedLines.Count() == 50);
+	CHECK(memcmp(&loadedPoints.Vtx()[0], &points.Vtx()[0], 100 * sizeof(vec3)) == 0);
+	CHECK(memcmp(&loadedLines.Vtx()[0], &lines.Vtx()[0], 100 * sizeof(vec3)) == 0);
+	int differ = 0;
+	for (int q = 0; q < 1000; q++) {
+		vec3 mouse(u(rng), u(rng), 1.0f);
+		differ += loadedLines.SelectLine(mouse) != lines.SelectLine(mouse);
+	}
+	CHECK(differ == 0);
+
+	std::vector<char> good = ReadFile(filename);
+	auto rejected = [&](const std::vector<char>& bytes) {
+		WriteFile(filename, bytes.empty() ? "" : &bytes[0], bytes.size());
+		PointCollection p;
+		LineCollection l;
+		bool loaded = LoadScene(filename, &p, &l);
+		return !loaded && p.Vtx().empty() && l.Count() == 0;
+	};
+	std::vector<char> bad = good;
+	uint32_t huge = 0xF0000000u;
+	memcpy(&bad[4], &huge, 4); //a régi betöltés ezzel bad_alloc-ot dobott
+	CHECK(rejected(bad));
+	bad = good;
+	memcpy(&bad[8], &huge, 4);
+	CHECK(rejected(bad));
+	bad = good;
+	bad.resize(bad.size() - 1); //csonka fájl
+	CHECK(rejected(bad));
+	bad = good;
+	bad.push_back(0); //fölösleges bájt a végén
+	CHECK(rejected(bad));
+	bad = good;
+	bad[0] = 'X';
+	CHECK(rejected(bad));
+	bad = good;
+	float nan = std::numeric_limits<float>::quiet_NaN();
+	memcpy(&bad[sizeof(SceneHeader) + 150 * sizeof(vec3)], &nan, 4);
+	CHECK(rejected(bad));
+	CHECK(rejected(std::vector<char>()));
+	remove(filename);
+	CHECK(!LoadScene(filename, &loadedPoints, &loadedLines));
+
+	//az 'o' sikertelen betöltés után megtartja a jelenetet és a visszavonási naplót: 5 pont, egy visszavonás,
+	//és a mentett fájlban 4 pont van
+	GreenTriangleApp sceneApp;
+	sceneApp.onInitialization();
+	sceneApp.onKeyboard('p');
+	for (int i = 0; i < 5; i++) sceneApp.onMousePressed(MOUSE_LEFT, 100 + 50 * i, 300);
+	bad = good;
+	memcpy(&bad[4], &huge, 4);
+	WriteFile("geometria_scene.bin", &bad[0], bad.size());
+	sceneApp.onKeyboard('o');
+	sceneApp.onKeyboard('z');
+	sceneApp.onKeyboard('s');
+	std::vector<char> saved = ReadFile("geometria_scene.bin");
+	SceneHeader header = {};
+	if (saved.size() >= sizeof(header)) memcpy(&header, &saved[0], sizeof(header));
+	CHECK(header.points == 4 && header.lines == 0);
+	sceneApp.onKeyboard('o'); //ez már sikerül
+	sceneApp.onKeyboard('s');
+	CHECK(ReadFile("geometria_scene.bin") == saved);
+	remove("geometria_scene.bin");
+}
+
+//Szöveges jelenet a betöltés alapvonalához: a bináris fájl tartalma, soronként egy vec3 ("x y z", %.9g-vel, így
+//a visszaolvasás pontos), előtte a pontok és egyenesek száma
+static bool SaveSceneText(const char* filename, PointCollection& points, LineCollection& lines) {
+	FILE* file = fopen(filename, "w");
+	if (!file) return false;
+	fprintf(file, "%zu %zu\n", points.Vtx().size(), lines.Count());
+	std::vector<vec3> all(points.Vtx());
+	all.insert(all.end(), lines.Vtx().begin(), lines.Vtx().end());
+	for (size_t i = 0; i < lines.Count(); i++) { all.push_back(lines.Get((int)i).getNormalP1()); all.push_back(lines.Get((int)i).getNormalP2()); }
+	for (const vec3& v : all) fprintf(file, "%.9g %.9g %.9g\n", v.x, v.y, v.z);
+	return fclose(file) == 0;
+}
+static bool LoadSceneText(const char* filename, PointCollection* points, LineCollection* lines) {
+	std::vector<char> text = ReadFile(filename);
+	text.push_back('\0');
+	char* p = &text[0];
+	size_t npoints = strtoul(p, &p, 10), nlines = strtoul(p, &p, 10);
+	std::vector<vec3> all(npoints + 4 * nlines);
+	for (vec3& v : all) {
+		v.x = strtof(p, &p); v.y = strtof(p, &p); v.z = strtof(p, &p);
+	}
+	points->Read(&all[0], npoints);
+	lines->Read(&all[npoints], &all[npoints + 2 * nlines], nlines);
+	return true;
+}
+//Jelenet betöltése: a bináris (mmap) és a szöveges alapvonal, egyformán a gyűjteményekbe (rács és index) töltve
+static void BenchScene() {
+	printf("\nScene load, binary (mmap) vs text baseline, n points + n lines\n");
+	printf("%10s %12s %12s %12s %12s %10s\n", "n", "binary [MB]", "text [MB]", "binary [ms]", "text [ms]", "speedup");
+	const char* binary = "geometria_bench.bin", * text = "geometria_bench.txt";
+	for (int n : { 10000, 100000, 1000000 }) {
+		PointCollection points;
+		LineCollection lines;
+		std::mt19937 rng(19);
+		std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+		for (int i = 0; i < n; i++) points.AddNew(vec3(u(rng), u(rng), 1.0f));
+		RandomLines(lines, n, 20);
+		CHECK(SaveScene(binary, &points, &lines) && SaveSceneText(text, points, lines));
+		double bytes[2] = { (double)ReadFile(binary).size(), (double)ReadFile(text).size() }, t[2];
+		PointCollection loadedPoints[2];
+		LineCollection loadedLines[2];
+		auto start = std::chrono::steady_clock::now();
+		CHECK(LoadScene(binary, &loadedPoints[0], &loadedLines[0]));
+		t[0] = Since(start);
+		start = std::chrono::steady_clock::now();
+		CHECK(LoadSceneText(text, &loadedPoints[1], &loadedLines[1]));
+		t[1] = Since(start);
+		for (int k = 0; k < 2; k++) {
+			CHECK(loadedPoints[k].Vtx().size() == (size_t)n && loadedLines[k].Count() == (size_t)n);
+			CHECK(memcmp(&loadedLines[k].Vtx()[0], &lines.Vtx()[0], 2 * n * sizeof(vec3)) == 0);
+		}
+		printf("%10d %12.1f %12.1f %12.1f %12.1f %9.1fx\n", n, bytes[0] / 1e6, bytes[1] / 1e6, t[0] * 1e3, t[1] * 1e3, t[1] / t[0]);
+		fflush(stdout);
+	}
+	remove(binary);
+	remove(text);
+}
+
+//250 ezer véletlen szerkesztés a 100 ezres korlátú naplóba: a méret a korláton belül marad, és a megmaradt
+//bejegyzések mind visszavonhatók, majd újra végrehajthatók
+static void TestJournal() {
+	PointCollection points;
+	LineCollection lines;
+	Journal journal(&points, &lines);
+	std::mt19937 rng(10);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	std::vector<std::pair<size_t, size_t>> states(1, std::make_pair(size_t(0), size_t(0))); //bejegyzésenként a darabszámok
+	const int edits = 250000;
+	for (int k = 0; k < edits; k++) {
+		int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+		if (kind < 4 || lines.Count() == 0) {
+			vec3 p(u(rng), u(rng), 1.0f);
+			points.AddNew(p);
+			journal.AddPoint(p);
+		}
+		else if (kind < 6) {
+			lines.AddNew(Line(vec3(u(rng), u(rng), 1.0f), vec3(u(rng), u(rng), 1.0f)));
+			journal.AddLine((int)lines.Count() - 1);
+		}
+		else if (kind < 9) {
+			//húzás: több mozgatás egy bejegyzésben
+			int id = std::uniform_int_distribution<int>(0, (int)lines.Count() - 1)(rng);
+			for (int m = 0; m < 5; m++) {
+				vec3 mouse(u(rng) * 0.5f, u(rng) * 0.5f, 1.0f);
+				Line& line = lines.Get(id);
+				journal.Translate(id, (line.getNormalP1() + line.getNormalP2()) / 2.0f, mouse);
+				lines.Translate(id, mouse);
+			}
+			journal.Close();
+		}
+		else {
+			for (int i = 0; i < 3; i++) points.AddNew(vec3(u(rng), u(rng), 1.0f));
+			journal.AddCrossPoints(3);
+		}
+		states.push_back(std::make_pair(points.Vtx().size(), lines.Count()));
+	}
+	const size_t budget = 100000 * 64; //legfeljebb 64 bájt bejegyzésenként
+	CHECK(journal.Size() == 100000);
+	CHECK(journal.Bytes() <= budget);
+
+	std::vector<vec3> pointsAfter = points.Vtx(), linesAfter = lines.Vtx();
+	int undone = 0;
+	while (journal.Undo()) undone++;
+	CHECK(undone == 100000);
+	CHECK(points.Vtx().size() == states[edits - 100000].first && lines.Count() == states[edits - 100000].second);
+	//a visszavont metszéspontok a naplóban várnak, legfeljebb annyi, amennyi a jelenetből kikerült
+	size_t bytes = journal.Bytes();
+	CHECK(bytes > budget / 2 && bytes <= budget + (pointsAfter.size() - points.Vtx().size()) * sizeof(vec3));
+	int redone = 0;
+	while (journal.Redo()) redone++;
+	CHECK(redone == 100000);
+	CHECK(points.Vtx().size() == pointsAfter.size() && lines.Vtx().size() == linesAfter.size());
+	CHECK(memcmp(&points.Vtx()[0], &pointsAfter[0], pointsAfter.size() * sizeof(vec3)) == 0);
+	float error = 0.0f;
+	for (size_t i = 0; i < linesAfter.size(); i++) {
+		error = std::max(error, std::max(fabs(lines.Vtx()[i].x - linesAfter[i].x), fabs(lines.Vtx()[i].y - linesAfter[i].y)));
+	}
+	CHECK(error < 1e-4f);
+	CHECK(journal.Bytes() <= budget);
+
+	//egy új szerkesztés eldobja az újra végrehajtható részt a tárolt pontokkal együtt
+	size_t full = journal.Bytes();
+	for (int i = 0; i < 100; i++) journal.Undo();
+	points.AddNew(vec3(0.0f, 0.0f, 1.0f));
+	journal.AddPoint(vec3(0.0f, 0.0f, 1.0f));
+	CHECK(!journal.Redo());
+	CHECK(journal.Bytes() == full / 100000 * journal.Size());
+}
+
+//Az intersect-all visszavonása és újra végrehajtása a metszéspontok számával arányos, nem számol újra
+static void BenchJournal() {
+	printf("\nUndo/redo of intersect-all vs recomputing it\n");
+	printf("%8s %12s %12s %12s %14s\n", "lines", "crossings", "undo [ms]", "redo [ms]", "intersect [ms]");
+	for (int n : { 1000, 4000 }) {
+		PointCollection points;
+		LineCollection lines;
+		Journal journal(&points, &lines);
+		RandomLines(lines, n, 11);
+		auto start = std::chrono::steady_clock::now();
+		std::vector<vec3> crosspoints = lines.IntersectAll();
+		double intersect = Since(start);
+		for (const vec3& p : crosspoints) points.AddNew(p);
+		journal.AddCrossPoints((int)crosspoints.size());
+		start = std::chrono::steady_clock::now();
+		journal.Undo();
+		double undo = Since(start);
+		start = std::chrono::steady_clock::now();
+		journal.Redo();
+		double redo = Since(start);
+		CHECK(points.Vtx().size() == crosspoints.size());
+		printf("%8d %12zu %12.2f %12.2f %14.2f\n", n, crosspoints.size(), undo * 1e3, redo * 1e3, intersect * 1e3);
+	}
+}
+
+//Majdnem párhuzamos egyenesek: a float nevező a hibakorlát alatt van, a double/fma ág adja a pontos metszéspontot.
+//l1 az y = x, l2 (-0.5, -0.5 + 2^-25) és (0.5, 0.5 + 2^-23) között; a különbségük x = -0.5-nél 2^-25, x = 0.5-nél 2^-23,
+//így pontosan x = y = -0.5 - 1/3-ban metszik egymást. A float együtthatókkal számolva -0.625 jönne ki.
+static void TestNearlyParallel() {
+	Line l1(vec3(-0.5f, -0.5f, 1.0f), vec3(0.5f, 0.5f, 1.0f));
+	Line l2(vec3(-0.5f, -0.5f + ldexpf(1.0f, -25), 1.0f), vec3(0.5f, 0.5f + ldexpf(1.0f, -23), 1.0f));
+	float ab = l1.getA() * l2.getB(), ba = l2.getA() * l1.getB();
+	CHECK(fabs(ab - ba) <= 5e-7f * (fabs(ab) + fabs(ba))); //a float ágat a szűrő elveti
+	vec3 plain = PlainCrossPoint(l1, l2), p, q;
+	CHECK(fabs(plain.x + 0.625f) < 1e-6f);
+	CHECK(l1.Intersect(l2, p) && l2.Intersect(l1, q));
+	CHECK(fabs(p.x + 0.5f + 1.0f / 3.0f) < 1e-6f && fabs(p.y + 0.5f + 1.0f / 3.0f) < 1e-6f);
+	CHECK(fabs(q.x - p.x) < 1e-6f && fabs(q.y - p.y) < 1e-6f);
+	//a definiáló pontokban is pontosan párhuzamos: nincs metszéspont
+	Line l3(vec3(-0.5f, -0.25f, 1.0f), vec3(0.5f, 0.75f, 1.0f));
+	CHECK(!l1.Intersect(l3, p));
+	//jól kondicionált párnál a float ág eredménye marad, ugyanaz, mint a szűrés előtt
+	Line l4(vec3(-0.5f, 0.5f, 1.0f), vec3(0.5f, -0.3f, 1.0f));
+	plain = PlainCrossPoint(l1, l4);
+	CHECK(l1.Intersect(l4, p) && p.x == plain.x && p.y == plain.y);
+}
+
+//IntersectAll: párhuzamos, azonos és függőleges egyenesek, valamint véletlen jelenet a sima ciklushoz mérve
+static void TestIntersectAll() {
+	LineCollection lines;
+	for (float y : { -0.5f, 0.0f, 0.5f }) lines.AddNew(Line(vec3(-0.3f, y, 1.0f), vec3(0.3f, y, 1.0f)));
+	lines.AddNew(Line(vec3(-0.3f, 0.0f, 1.0f), vec3(0.3f, 0.0f, 1.0f))); //az y = 0 még egyszer
+	for (float x : { -0.5f, 0.5f }) lines.AddNew(Line(vec3(x, -0.3f, 1.0f), vec3(x, 0.3f, 1.0f)));
+	lines.AddNew(Line(vec3(-0.9f, 0.9f, 1.0f), vec3(0.9f, 0.9f + 1e-6f, 1.0f))); //majdnem vízszintes, az ablakon belül nem metsz
+	std::vector<vec3> crosspoints = lines.IntersectAll();
+	//4 vízszintes x 2 függőleges, és a majdnem vízszintes a két függőlegest y = 0.9 körül
+	CHECK(crosspoints.size() == 10);
+	for (const vec3& p : crosspoints) CHECK(std::isfinite(p.x) && std::isfinite(p.y) && p.z == 1.0f);
+
+	LineCollection random;
+	RandomLines(random, 1500, 1);
+	std::vector<vec3> all = random.IntersectAll(), plain = IntersectAllPlain(random);
+	CHECK(all.size() == plain.size());
+	size_t differ = 0;
+	for (size_t i = 0; i < std::min(all.size(), plain.size()); i++) {
+		if (fabs(all[i].x - plain[i].x) > 1e-5f || fabs(all[i].y - plain[i].y) > 1e-5f) differ++;
+	}
+	CHECK(differ == 0);
+}
+
+//Eseménynapló: szintszűrés, kategóriánkénti mintavétel és eldobás teli puffernél. A naplók saját példányok, a kimenet
+//fájlba, illetve a teli pufferhez egy csőbe megy, amelyet az olvasás előtt senki nem ürít, így az író szál elakad.
+static void Logged(EventLog& log, LogLevel level, LogCategory category, int i) {
+	if (log.Enabled(level, category)) log.Log(level, category, "message %d", i);
+}
+static std::vector<std::string> Lines(const std::vector<char>& text) {
+	std::vector<std::string> lines;
+	std::string line;
+	for (char c : text) {
+		if (c != '\n') { line += c; continue; }
+		lines.push_back(line);
+		line.clear();
+	}
+	return lines;
+}
+static void TestEventLog() {
+	const char* filename = "geometria_log.txt";
+	FILE* file = fopen(filename, "w");
+	EventLog* log = new EventLog();
+	log->SetOutput(file);
+	log->SetLevel(LOG_WARN);
+	CHECK(!log->Enabled(LOG_DEBUG, LOG_EDIT) && !log->Enabled(LOG_INFO, LOG_EDIT) && log->Enabled(LOG_WARN, LOG_EDIT));
+	for (LogLevel level : { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR }) Logged(*log, level, LOG_EDIT, (int)level);
+	//minden tizedik húzás-üzenet, a többi kategória érintetlen
+	log->SetLevel(LOG_DEBUG);
+	log->SetSampling(LOG_DRAG, 10);
+	for (int i = 0; i < 1000; i++) Logged(*log, LOG_DEBUG, LOG_DRAG, i);
+	for (int i = 0; i < 5; i++) Logged(*log, LOG_DEBUG, LOG_PATH, i);
+	log->SetLevel(LOG_OFF);
+	Logged(*log, LOG_ERROR, LOG_GENERAL, 0);
+	delete log; //a leállítás kiírja a maradékot
+	fclose(file);
+	std::vector<std::string> lines = Lines(ReadFile(filename));
+	CHECK(lines.size() == 2 + 100 + 5);
+	if (lines.size() == 107) {
+		CHECK(lines[0] == "[warn][edit] message 2" && lines[1] == "[error][edit] message 3");
+		CHECK(lines[2] == "[debug][drag] message 0" && lines[3] == "[debug][drag] message 10" && lines[101] == "[debug][drag] message 990");
+		CHECK(lines[102] == "[debug][path] message 0" && lines[106] == "[debug][path] message 4");
+	}
+	remove(filename);
+
+	//teli puffer: a hívó nem vár, a többlet eldobódik, és a következő kiírás jelzi a számukat
+	int fds[2];
+	CHECK(pipe(fds) == 0);
+	FILE* in = fdopen(fds[0], "r"), * out = fdopen(fds[1], "w");
+	std::string received;
+	const int total = 20000;
+	log = new EventLog();
+	log->SetOutput(out);
+	for (int i = 0; i < total; i++) Logged(*log, LOG_INFO, LOG_GENERAL, i);
+	//a napló leállítása ürít: ehhez már olvasni kell a csövet
+	std::thread reader([&]() {
+		char buffer[4096];
+		size_t n;
+		while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) received.append(buffer, n);
+	});
+	delete log;
+	fclose(out);
+	reader.join();
+	fclose(in);
+	std::vector<std::string> got = Lines(std::vector<char>(received.begin(), received.end()));
+	long messages = 0, dropped = 0, reports = 0, last = -1, ordered = 1;
+	for (const std::string& line : got) {
+		long n;
+		if (sscanf(line.c_str(), "[warn][general] %ld log messages dropped", &n) == 1) { dropped += n; reports++; continue; }
+		if (sscanf(line.c_str(), "[info][general] message %ld", &n) != 1) continue;
+		ordered &= n > last;
+		last = n;
+		messages++;
+	}
+	CHECK(messages + dropped == total);
+	CHECK(dropped > total / 2 && reports >= 1 && ordered);
+}
+
+//LineCoeffs kernelei: a CrossPoints AVX2-es ága egyezik a skaláris maradékkal (n = 1 hívások) és az Intersect float
+//ágával, a FirstOnLine az onLine-nal; 8-cal nem osztható hosszakra és eltolt kezdetre is, közel párhuzamos párokkal
+static void TestLineKernels() {
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	std::vector<Line> lines;
+	LineCoeffs coeffs;
+	for (int i = 0; i < 1003; i++) {
+		vec3 a(u(rng), u(rng), 1.0f), b(u(rng), u(rng), 1.0f);
+		if (i % 10 == 9) { b = a + (lines[i - 1].getNormalP2() - lines[i - 1].getNormalP1()) * 0.5f; b.z = 1.0f; } //közel párhuzamos az előzővel
+		lines.push_back(Line(a, b));
+		coeffs.Set(i, lines[i]);
+	}
+	//A két ág kerekítése (fma-összevonás, osztás sorrendje) eltérhet: a tűrés a nevező kondíciószámával arányos,
+	//|ab| + |ba| / |ab - ba| (közel párhuzamos párnál nagy, merőlegesnél 1)
+	auto near = [&](int i, int j, float a, float b) {
+		float ab = lines[i].getA() * lines[j].getB(), ba = lines[j].getA() * lines[i].getB();
+		float cond = (fabs(ab) + fabs(ba)) / fabs(ab - ba);
+		return fabs(a - b) <= 8.0f * std::numeric_limits<float>::epsilon() * cond * (1.0f + fabs(b));
+	};
+	size_t crossDiffer = 0, intersectDiffer = 0, parallel = 0;
+	std::vector<float> x(lines.size()), y(lines.size());
+	for (int l = 0; l < 40; l++) {
+		for (int n : { 1, 7, 8, 9, 15, 16, 61, 1003 - l - 1 }) {
+			int first = l + 1;
+			coeffs.CrossPoints(l, first, n, &x[0], &y[0]);
+			for (int k = 0; k < n; k++) {
+				float tx, ty;
+				coeffs.CrossPoints(l, first + k, 1, &tx, &ty);
+				if ((x[k] != x[k]) != (tx != tx)) { crossDiffer++; continue; }
+				if (tx != tx) { parallel++; continue; }
+				if (!near(l, first + k, x[k], tx) || !near(l, first + k, y[k], ty)) crossDiffer++;
+				vec3 p;
+				if (!lines[l].Intersect(lines[first + k], p) || !near(l, first + k, p.x, tx) || !near(l, first + k, p.y, ty)) intersectDiffer++;
+			}
+		}
+	}
+	CHECK(crossDiffer == 0);
+	CHECK(intersectDiffer == 0);
+	CHECK(parallel > 0);
+
+	size_t firstDiffer = 0, hits = 0;
+	for (int i = 0; i < 2000; i++) {
+		int first = i % 13, n = (int)(rng() % (lines.size() - first)) + 1;
+		//az egér felváltva egy véletlen egyenesen (találat a tartomány belsejében) és véletlen helyen
+		vec3 mouse(u(rng), u(rng), 1.0f);
+		if (i % 2 == 0) {
+			Line& on = lines[first + rng() % n];
+			float t = (u(rng) + 1.0f) * 0.5f;
+			mouse = on.getNormalP1() + (on.getNormalP2() - on.getNormalP1()) * t;
+			mouse.z = 1.0f;
+		}
+		int expected = -1;
+		for (int k = first; k < first + n; k++) if (lines[k].onLine(mouse)) { expected = k; break; }
+		if (coeffs.FirstOnLine(mouse, first, n) != expected) firstDiffer++;
+		if (expected >= 0) hits++;
+	}
+	CHECK(firstDiffer == 0);
+	CHECK(hits > 1000);
+}
+
+//Line::Intersect (szűrt, ritkán double/fma) a szűrés előtti sima float képlethez mérve, véletlen egyenespárokon;
+//közel párhuzamos pár ebben alig van, a különbség a szűrő feltételének ára
+//A szűrt metszés két helyen fut: pontonként a Line::Intersect (az 'i' mód) és tömbösen az IntersectAll sorai
+//(LineCoeffs::CrossPoints, a NaN-nal jelölt párokra Intersect). Mindkettőt a szűrés nélküli float képlethez mérjük
+//ugyanazon a ciklusszerkezeten. A jellemző terhelés a tömbös; a pontonkénti ciklus magja olyan rövid, hogy ott
+//a szűrő néhány művelete is jól látszik.
+static void BenchIntersect() {
+	LineCollection lines;
+	RandomLines(lines, 2000, 21);
+	int n = (int)lines.Count();
+	std::vector<float> A(n), B(n), C(n), xs(n), ys(n);
+	LineCoeffs coeffs;
+	for (int i = 0; i < n; i++) {
+		A[i] = lines.Get(i).getA(); B[i] = lines.Get(i).getB(); C[i] = lines.Get(i).getC();
+		coeffs.Set(i, lines.Get(i));
+	}
+	auto inside = [](float x, float y) { return (x >= -1.0f) & (x <= 1.0f) & (y >= -1.0f) & (y <= 1.0f); };
+	double t[4] = { 1e9, 1e9, 1e9, 1e9 };
+	long hits[4];
+	//a ciklusok felváltva futnak, a legjobb idő számít (a gép többi terhelése így kevésbé torzít); a feltételek
+	//bitenkénti &-sel, hogy a fordító egyik ciklusban se hagyhassa ki az y számítását
+	for (int run = 0; run < 9; run++) {
+		hits[0] = hits[1] = hits[2] = hits[3] = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < n; i++) for (int j = i + 1; j < n; j++) {
+			vec3 p = PlainCrossPoint(lines.Get(i), lines.Get(j));
+			hits[0] += inside(p.x, p.y);
+		}
+		t[0] = std::min(t[0], Since(start));
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < n; i++) for (int j = i + 1; j < n; j++) {
+			vec3 p;
+			hits[1] += lines.Get(i).Intersect(lines.Get(j), p) & inside(p.x, p.y);
+		}
+		t[1] = std::min(t[1], Since(start));
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < n; i++) {
+			PlainCrossPoints(&A[0], &B[0], &C[0], i, i + 1, n - i - 1, &xs[i + 1], &ys[i + 1]);
+			for (int j = i + 1; j < n; j++) hits[2] += inside(xs[j], ys[j]);
+		}
+		t[2] = std::min(t[2], Since(start));
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < n; i++) {
+			if (coeffs.CrossPoints(i, i + 1, n - i - 1, &xs[i + 1], &ys[i + 1])) {
+				for (int j = i + 1; j < n; j++) {
+					vec3 p;
+					if (xs[j] == xs[j] || !lines.Get(i).Intersect(lines.Get(j), p)) continue;
+					xs[j] = p.x; ys[j] = p.y;
+				}
+			}
+			for (int j = i + 1; j < n; j++) hits[3] += inside(xs[j], ys[j]);
+		}
+		t[3] = std::min(t[3], Since(start));
+	}
+	double pairs = 0.5 * n * (n - 1.0);
+	printf("\nFiltered intersection vs plain float formula, %.0f random pairs, best of 9\n", pairs);
+	printf("%-24s %12s %14s %10s\n", "path", "plain [ns]", "filtered [ns]", "overhead");
+	printf("%-24s %12.2f %14.2f %9.1f%%\n", "Line::Intersect", t[0] / pairs * 1e9, t[1] / pairs * 1e9, (t[1] / t[0] - 1.0) * 100.0);
+	printf("%-24s %12.2f %14.2f %9.1f%%\n", "IntersectAll rows", t[2] / pairs * 1e9, t[3] / pairs * 1e9, (t[3] / t[2] - 1.0) * 100.0);
+	//a szűrt eredmény csak a rosszul kondicionált, ablakhatáron fekvő párokon térhet el
+	CHECK(labs(hits[0] - hits[1]) <= hits[0] / 10000);
+	CHECK(labs(hits[2] - hits[3]) <= hits[2] / 10000);
+}
+
+static void BenchIntersectAll() {
+	printf("\nIntersectAll (%u threads) vs plain double loop over Line::Intersect, 1 thread\n", std::thread::hardware_concurrency());
+	//a crossings/pairs arány n-től független: a kimenet maga négyzetes, ezt semmilyen kiválogatás nem csökkenti
+	printf("%8s %12s %8s %12s %12s %12s\n", "lines", "crossings", "/pairs", "all [s]", "plain [s]", "speedup");
+	for (int n : { 1000, 10000 }) {
+		LineCollection lines;
+		RandomLines(lines, n, 2);
+		auto start = std::chrono::steady_clock::now();
+		size_t count = lines.IntersectAll().size();
+		double all = Since(start);
+		start = std::chrono::steady_clock::now();
+		size_t plain = IntersectAllPlain(lines).size();
+		double loop = Since(start);
+		CHECK(count == plain);
+		printf("%8d %12zu %8.3f %12.3f %12.3f %11.1fx\n", n, count, count / (0.5 * n * (n - 1.0)), all, loop, loop / all);
+	}
+}
+
+int main(int argc, char** argv) {
+	eventLog().SetLevel(LOG_OFF);
+	bool bench = argc > 1 && strcmp(argv[1], "bench") == 0;
+	TestSelect();
+	TestDragDuplicates();
+	TestReplayWithoutGL();
+	TestScene();
+	TestJournal();
+	TestIntersectAll();
+	TestNearlyParallel();
+	TestLineKernels();
+	TestEventLog();
+	if (bench) {
+		BenchSelect();
+		BenchDrag();
+		BenchDragLogging();
+		BenchScene();
+		BenchJournal();
+		BenchIntersect();
+		BenchIntersectAll();
+	}
+	printf("geometria_test: %s\n", failures == 0 ? "OK" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
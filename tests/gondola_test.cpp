@@ -0,0 +1,599 @@
+//=============================================================================================
+// gondola.cpp tesztjei és mérései GL nélkül (a csonk framework.h-val). "bench" argumentummal a mérések is futnak.
+//=============================================================================================
+#include "../gondola.cpp"
+#include <random>
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static double Since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+//Az alkalmazás pályája (az onMousePressed kontrollpontjai)
+static Spline* MakeTrack() {
+	if (!camera) camera = new Camera(vec3(0.0f, 0.0f, 0.0f), vec3(20.0f, 20.0f, 1.0f));
+	Spline* track = new Spline();
+	const int pixels[8][2] = { { 50, 85 }, { 163, 503 }, { 408, 501 }, { 344, 311 }, { 218, 376 }, { 286, 478 }, { 451, 440 }, { 557, 55 } };
+	for (auto& p : pixels) track->AddControlPoint(camera->ScreenToWorld(vec3((float)p[0], (float)p[1], 1.0f)));
+	track->AddSpline();
+	return track;
+}
+//Meredek lejtő, majd egy púp, amelyen a kerék nagy sebességgel lerepül
+static Spline* MakeHumpTrack() {
+	Spline* track = new Spline();
+	const float points[7][2] = { { -19, 19 }, { -12, -12 }, { -6, -15 }, { 0, -11 }, { 6, -15 }, { 12, -15 }, { 19, -15 } };
+	for (auto& p : points) track->AddControlPoint(vec3(p[0], p[1], 1.0f));
+	track->AddSpline();
+	return track;
+}
+//n kontrollpontos véletlen pálya a kamera ablakán belül
+static Spline* MakeRandomTrack(int n, unsigned seed) {
+	if (!camera) camera = new Camera(vec3(0.0f, 0.0f, 0.0f), vec3(20.0f, 20.0f, 1.0f));
+	Spline* track = new Spline();
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> u(-19.0f, 19.0f);
+	for (int i = 0; i < n; i++) track->AddControlPoint(vec3(u(rng), u(rng), 1.0f));
+	return track;
+}
+//A régi, lineáris szakaszkeresés (az első i, amelyre ts[i] <= t <= ts[i+1]), -1 ha nincs ilyen
+static int FindSegmentLinear(Spline* track, float t) {
+	for (size_t i = 0; i + 1 < track->ts.size(); i++) if (track->ts[i] <= t && t <= track->ts[i + 1]) return (int)i;
+	return -1;
+}
+//n kerék a pálya első tizedén elosztva, mint a 'g' billentyűnél
+static void AddWheels(GondolaSystem& system, Spline* track, int n, int first = 0, int total = 0) {
+	if (total == 0) total = n;
+	for (int i = first; i < first + n; i++) system.Add(track->Length() * 0.1f * (i + 1) / total);
+}
+static bool SameState(GondolaSystem& a, size_t ia, GondolaSystem& b, size_t ib) {
+	return a.tau[ia] == b.tau[ib] && a.ivhossz[ia] == b.ivhossz[ib] && a.v[ia] == b.v[ib] && a.elfordulas[ia] == b.elfordulas[ib] &&
+		a.state[ia] == b.state[ib] && a.cposition[ia].x == b.cposition[ib].x && a.cposition[ia].y == b.cposition[ib].y;
+}
+
+//A képkockánkénti felosztás ugyanazt adja, mint a lépésenkénti, és a szálak felosztása sem számít
+static void TestSystemSteps() {
+	Spline* track = MakeTrack();
+	WheelMesh mesh;
+	GondolaSystem perFrame(track, &mesh), perStep(track, &mesh);
+	AddWheels(perFrame, track, 1000);
+	AddWheels(perStep, track, 1000);
+	for (int frame = 0; frame < 120; frame++) {
+		perFrame.Advance(1.0f / 60.0f);
+		for (int k = 0; k < 4; k++) perStep.Step(1, physicsStep);
+	}
+	int differ = 0;
+	for (size_t w = 0; w < perFrame.Count(); w++) differ += !SameState(perFrame, w, perStep, w);
+	CHECK(differ == 0);
+
+	//8000 kerék egyben (több szálon, ha van több mag), illetve 8 darab 1000-es rendszerben
+	GondolaSystem all(track, &mesh);
+	AddWheels(all, track, 8000);
+	std::vector<GondolaSystem*> parts;
+	for (int p = 0; p < 8; p++) {
+		parts.push_back(new GondolaSystem(track, &mesh));
+		AddWheels(*parts.back(), track, 1000, p * 1000, 8000);
+	}
+	all.Step(100, physicsStep);
+	for (GondolaSystem* part : parts) part->Step(100, physicsStep);
+	differ = 0;
+	for (size_t w = 0; w < all.Count(); w++) differ += !SameState(all, w, *parts[w / 1000], w % 1000);
+	CHECK(differ == 0);
+	for (GondolaSystem* part : parts) delete part;
+	delete track;
+}
+
+//A kötegelt Eval ugyanazt adja, mint az r, rt és rtt: véletlen (nem monoton) paraméterekre, a szakaszhatárokon,
+//az utolsó kontrollponton és a pályán túl; a darabszám nem többszöröse a 64-es kötegnek
+static void TestBatchedEval() {
+	Spline* track = MakeTrack();
+	std::vector<float> t;
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> u(track->ts.front(), track->ts.back());
+	for (int i = 0; i < 1000; i++) t.push_back(u(rng));
+	for (float knot : track->ts) { t.push_back(knot); t.push_back(std::nextafter(knot, knot + 1.0f)); t.push_back(std::nextafter(knot, knot - 1.0f)); }
+	t.push_back(track->ts.back());
+	t.push_back(track->ts.back() + 0.5f); //pályán kívül: mindhárom az utolsó kontrollpont
+	std::vector<SplineSample> batch(t.size()), hinted(t.size());
+	track->Eval(&t[0], (int)t.size(), &batch[0]);
+	int hint = 3;
+	track->Eval(&t[0], (int)t.size(), &hinted[0], &hint);
+	auto same = [](const vec3& a, const vec3& b) {
+		return fabs(a.x - b.x) <= 1e-5f * (1.0f + fabs(b.x)) && fabs(a.y - b.y) <= 1e-5f * (1.0f + fabs(b.y)) && a.z == b.z;
+	};
+	int differ = 0;
+	for (size_t k = 0; k < t.size(); k++) {
+		vec3 r = track->r(t[k]), rt = track->rt(t[k]), rtt = track->rtt(t[k]);
+		differ += !same(batch[k].r, r) || !same(batch[k].rt, rt) || !same(batch[k].rtt, rtt);
+		differ += !same(hinted[k].r, r) || !same(hinted[k].rt, rt) || !same(hinted[k].rtt, rtt);
+	}
+	CHECK(differ == 0);
+	vec3 last = track->ControlPoints.Vtx().back();
+	CHECK(same(batch[t.size() - 2].r, last) && same(batch.back().r, last) && same(batch.back().rtt, last));
+	delete track;
+}
+
+//Új kontrollpont után csak a pálya végének szakaszai bomlanak újra: a korábbi szakaszok csúcsaiba írt jelölő
+//megmarad, az eredmény pedig (a jelölő nélkül) ugyanaz, mint a teljes felbontásé. A tűrés változása mindent újrabont.
+static void TestIncrementalTessellation() {
+	Spline* track = MakeRandomTrack(50, 16);
+	track->AddSpline();
+	std::vector<vec3>& vtx = track->SplinePoints.Vtx();
+	size_t before = vtx.size(), mid = before / 2;
+	vec3 first = vtx[0], middle = vtx[mid], mark(1000.0f, 1000.0f, 1.0f);
+	vtx[0] = mark; vtx[mid] = mark;
+	track->AddControlPoint(vec3(5.0f, 5.0f, 1.0f));
+	track->AddSpline();
+	CHECK(vtx.size() > before);
+	CHECK(vtx[0].x == mark.x && vtx[mid].x == mark.x);
+	vtx[0] = first; vtx[mid] = middle;
+
+	Spline* full = MakeRandomTrack(50, 16);
+	full->AddControlPoint(vec3(5.0f, 5.0f, 1.0f));
+	full->AddSpline();
+	std::vector<vec3>& expected = full->SplinePoints.Vtx();
+	CHECK(vtx.size() == expected.size() && memcmp(&vtx[0], &expected[0], vtx.size() * sizeof(vec3)) == 0);
+
+	vtx[0] = mark;
+	track->SetTolerance(0.5f);
+	track->AddSpline();
+	CHECK(vtx[0].x == first.x && vtx[0].y == first.y);
+	delete track;
+	delete full;
+}
+
+//FindSegment ugyanazt adja, mint a lineáris keresés: a csomópontokon pontosan (a korábbi szakasz), közvetlenül
+//mellettük, véletlen és monoton sorrendben, a közös és a külön tippel, valamint a pályán kívül
+static void TestFindSegment() {
+	Spline* track = MakeRandomTrack(2001, 12);
+	std::vector<float> t;
+	for (float knot : track->ts) { t.push_back(knot); t.push_back(std::nextafter(knot, knot + 1.0f)); t.push_back(std::nextafter(knot, knot - 1.0f)); }
+	std::mt19937 rng(13);
+	std::uniform_real_distribution<float> u(track->ts.front() - 1.0f, track->ts.back() + 1.0f);
+	for (int i = 0; i < 4000; i++) t.push_back(u(rng));
+	t.push_back(std::numeric_limits<float>::quiet_NaN());
+	int differ = 0, hint = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		if (pass == 1) std::shuffle(t.begin(), t.end(), rng);
+		for (float x : t) {
+			int expected = FindSegmentLinear(track, x);
+			differ += track->FindSegment(x) != expected;
+			differ += track->FindSegment(x, hint) != expected;
+		}
+	}
+	//a tipp már a csomópont utáni szakaszon áll, a csomópont mégis a korábbihoz tartozik
+	for (size_t k = 1; k + 1 < track->ts.size(); k++) {
+		track->FindSegment(std::nextafter(track->ts[k], track->ts[k] + 1.0f), hint);
+		differ += track->FindSegment(track->ts[k], hint) != (int)k - 1;
+	}
+	CHECK(differ == 0);
+	CHECK(track->FindSegment(track->ts[1]) == 0 && track->FindSegment(track->ts.back()) == (int)track->ts.size() - 2);
+	delete track;
+}
+
+//Ívhossz-táblázat: ParamAt(ArcLength(t)) visszaadja t-t, és a hossz egyezik a sűrű töröttvonaléval
+static void TestArcLength() {
+	for (Spline* track : { MakeTrack(), MakeRandomTrack(200, 8) }) {
+		//töröttvonal szakaszonként 2000 részre; a húrok hossza alulról közelít, az eltérés O(1/2000^2)
+		double polyline = 0.0;
+		std::vector<double> atKnot(1, 0.0);
+		for (size_t i = 0; i + 1 < track->ts.size(); i++) {
+			for (int k = 0; k < 2000; k++) {
+				float t0 = track->ts[i] + (track->ts[i + 1] - track->ts[i]) * k / 2000.0f;
+				float t1 = k == 1999 ? track->ts[i + 1] : track->ts[i] + (track->ts[i + 1] - track->ts[i]) * (k + 1) / 2000.0f;
+				polyline += length(track->r(t1) - track->r(t0));
+			}
+			atKnot.push_back(polyline);
+		}
+		CHECK(fabs(track->Length() - polyline) <= 1e-4 * polyline);
+		int knotDiffer = 0;
+		for (size_t i = 0; i < track->ts.size(); i++) knotDiffer += fabs(track->ArcLength(track->ts[i]) - atKnot[i]) > 1e-4 * polyline;
+		CHECK(knotDiffer == 0);
+
+		//ParamAt(ArcLength(t)) = t a float ívhossz kerekítéséig (~1e-7 * hossz), ami t-ben a sebességgel osztva jelenik meg:
+		//csúcs közelében (sebesség ~ 0) t rosszul kondicionált, ott az ívhosszban mérünk
+		std::mt19937 rng(9);
+		std::uniform_real_distribution<float> u(track->ts.front(), track->ts.back());
+		float worstT = 0.0f, worstS = 0.0f;
+		for (int i = 0; i < 10000; i++) {
+			float t = u(rng), s = track->ArcLength(t), back = track->ParamAt(s);
+			worstS = std::max(worstS, fabs(track->ArcLength(back) - s));
+			if (length(track->rt(t)) >= 1.0f) worstT = std::max(worstT, fabs(back - t));
+		}
+		CHECK(worstS <= 1e-6f * track->Length());
+		CHECK(worstT < 1e-3f);
+		CHECK(track->ParamAt(0.0f) == track->ts.front() && fabs(track->ParamAt(track->Length()) - track->ts.back()) < 1e-3f);
+		delete track;
+	}
+}
+
+//Kamera: képernyő -> világ -> képernyő oda-vissza a VP mátrixszal, nagyítás és eltolás után is
+static void TestCameraRoundTrip() {
+	Camera* saved = camera;
+	camera = new Camera(vec3(0.0f, 0.0f, 0.0f), vec3(20.0f, 20.0f, 1.0f));
+	auto toScreen = [](const vec3& world) {
+		vec4 ndc = camera->VP() * vec4(world.x, world.y, 0.0f, 1.0f); //mint az árnyaló
+		return vec3((ndc.x + 1.0f) * 0.5f * winWidth, (1.0f - ndc.y) * 0.5f * winHeight, 1.0f);
+	};
+	const float pixels[5][2] = { { 0, 0 }, { 300, 300 }, { 599, 0 }, { 17, 583 }, { 451, 440 } };
+	float worst = 0.0f;
+	for (int view = 0; view < 4; view++) {
+		if (view == 1) camera->Zoom(0.5f);
+		if (view == 2) camera->Pan(vec3(3.0f, -2.0f, 0.0f));
+		if (view == 3) { camera->Zoom(3.0f); camera->Pan(vec3(-40.0f, 7.5f, 0.0f)); }
+		for (auto& p : pixels) {
+			vec3 screen = toScreen(camera->ScreenToWorld(vec3(p[0], p[1], 1.0f)));
+			worst = std::max(worst, std::max(fabs(screen.x - p[0]), fabs(screen.y - p[1])));
+		}
+	}
+	CHECK(worst < 1e-3f);
+	//a képernyő közepe a kamera középpontja, a széle a középpont +- fél-méret
+	vec3 center = camera->ScreenToWorld(vec3(300.0f, 300.0f, 1.0f)), corner = camera->ScreenToWorld(vec3(0.0f, 0.0f, 1.0f));
+	CHECK(fabs(center.x + 37.0f) < 1e-4f && fabs(center.y - 5.5f) < 1e-4f);
+	CHECK(fabs(corner.x - (-37.0f - 30.0f)) < 1e-4f && fabs(corner.y - (5.5f + 30.0f)) < 1e-4f);
+	delete camera;
+	camera = saved;
+}
+
+//Rajzoló hívások tartalmának rögzítése: a pálya töröttvonalainak tartományai és a példányos kerekek száma
+class RecordingBackend : public CountingBackend {
+public:
+	std::vector<int> first, count;
+	int instances = 0, wheels = 0;
+	void MultiDrawArrays(unsigned int vao, int type, const int* f, const int* c, int drawcount, int base, const vec3* vtx) {
+		CountingBackend::MultiDrawArrays(vao, type, f, c, drawcount, base, vtx);
+		if (type == GL_LINE_STRIP) { first.insert(first.end(), f, f + drawcount); count.insert(count.end(), c, c + drawcount); }
+	}
+	void DrawArrays(unsigned int vao, int type, int f, int c, const vec3* vtx) {
+		CountingBackend::DrawArrays(vao, type, f, c, vtx);
+		wheels++;
+	}
+	void DrawArraysInstanced(unsigned int vao, int type, int f, int c, int instancecount, const vec3* vtx, const vec3* inst) {
+		CountingBackend::DrawArraysInstanced(vao, type, f, c, instancecount, vtx, inst);
+		instances = instancecount;
+	}
+	void Clear() { first.clear(); count.clear(); instances = 0; wheels = 0; }
+};
+
+//A képen kívüli pályaszakaszok és kerekek kimaradnak a rajzolásból, a láthatók (és a képen belüli csúcsok) nem
+static void TestOffscreenCulling() {
+	Camera* saved = camera;
+	camera = new Camera(vec3(0.0f, 0.0f, 0.0f), vec3(20.0f, 20.0f, 1.0f));
+	Spline* track = MakeTrack();
+	WheelMesh mesh;
+	Gondola gondola(track, &mesh);
+	GondolaSystem system(track, &mesh);
+	gondola.Start();
+	AddWheels(system, track, 200);
+	system.Advance(1.0f / 60.0f);
+	gondola.Animate(1.0f / 60.0f);
+	RecordingBackend recording;
+	std::vector<vec3>& vtx = track->SplinePoints.Vtx();
+	auto drawn = [&]() { int n = 0; for (int c : recording.count) n += c; return n; };
+	//egy csúcs a képen belül van-e, és benne van-e valamelyik rajzolt tartományban
+	auto missing = [&]() {
+		int n = 0;
+		vec3 lo = camera->ScreenToWorld(vec3(0.0f, (float)winHeight, 0.0f)), hi = camera->ScreenToWorld(vec3((float)winWidth, 0.0f, 0.0f));
+		for (size_t j = 0; j < vtx.size(); j++) {
+			if (vtx[j].x < lo.x || vtx[j].x > hi.x || vtx[j].y < lo.y || vtx[j].y > hi.y) continue;
+			bool in = false;
+			for (size_t k = 0; k < recording.first.size(); k++) in |= (int)j >= recording.first[k] && (int)j < recording.first[k] + recording.count[k];
+			n += !in;
+		}
+		return n;
+	};
+	//a kerekek közül a képen (a kerék sugarával, 2, bővítve) lévők
+	auto visibleWheels = [&]() {
+		int n = 0;
+		vec3 lo = camera->ScreenToWorld(vec3(0.0f, (float)winHeight, 0.0f)), hi = camera->ScreenToWorld(vec3((float)winWidth, 0.0f, 0.0f));
+		for (size_t w = 0; w < system.Count(); w++) {
+			vec3 c = system.prevpos[w] + (system.cposition[w] - system.prevpos[w]) * system.alpha;
+			n += c.x >= lo.x - 2.0f && c.x <= hi.x + 2.0f && c.y >= lo.y - 2.0f && c.y <= hi.y + 2.0f;
+		}
+		return n;
+	};
+
+	track->Draw(&recording, nullptr);
+	system.Draw(&recording, nullptr);
+	int all = drawn();
+	CHECK(all == (int)vtx.size() && recording.first.size() == 1);
+	CHECK(recording.instances == (int)system.Count());
+
+	//nagyítva a pálya egy sarkára: kevesebb csúcs, de egy képen belüli sem marad ki
+	camera->Zoom(0.25f);
+	camera->Pan(vec3(-12.0f, 12.0f, 0.0f));
+	recording.Clear();
+	track->Draw(&recording, nullptr);
+	system.Draw(&recording, nullptr);
+	CHECK(drawn() > 0 && drawn() < all / 2);
+	CHECK(missing() == 0);
+	CHECK(recording.instances == visibleWheels() && recording.instances < (int)system.Count());
+
+	//a pályától messze: se töröttvonal, se kerék
+	camera->Pan(vec3(200.0f, 0.0f, 0.0f));
+	recording.Clear();
+	track->Draw(&recording, nullptr);
+	system.Draw(&recording, nullptr);
+	gondola.Draw(&recording, nullptr);
+	CHECK(recording.first.empty() && recording.instances == 0 && recording.wheels == 0);
+	delete track;
+	delete camera;
+	camera = saved;
+}
+
+//FNV-1a ellenőrzőösszeg a képpontokra
+static uint64_t Checksum(const std::vector<uint32_t>& pixels) {
+	uint64_t h = 14695981039346656037ull;
+	for (uint32_t p : pixels) for (int b = 0; b < 4; b++) { h ^= (p >> (8 * b)) & 0xff; h *= 1099511628211ull; }
+	return h;
+}
+
+//A szoftveres kép a backenden át készül: egyetlen GL hívás nélkül, a rögzített referenciaképpel egyezően (a pálya,
+//a kerék és a kerekek ellenőrzőösszege), és ugyanaz egy szálon és több szálon. Ha a raszterizálás szándékosan
+//változik, a referencia-összeget a kiírt értékre kell cserélni.
+static void TestRenderFrameWithoutGL() {
+	const uint64_t golden = 0x30db0ec3bbcf2766ull;
+	Spline* track = MakeTrack();
+	WheelMesh mesh;
+	Gondola gondola(track, &mesh);
+	gondola.Start();
+	GondolaSystem system(track, &mesh);
+	AddWheels(system, track, 100);
+	gondola.Animate(1.0f / 60.0f);
+	system.Advance(1.0f / 60.0f);
+	SoftwareRenderer renderer(winWidth, winHeight);
+	long calls = GLCalls();
+	RenderFrame(renderer, track, &gondola, &system);
+	RenderFrame(renderer, track, &gondola, &system);
+	CHECK(GLCalls() == calls);
+	size_t lit = 0;
+	for (uint32_t p : renderer.Pixels()) lit += p != renderer.Pixels()[0];
+	CHECK(lit > 1000);
+	uint64_t sum[3];
+	int threads[3] = { 1, 3, 8 };
+	for (int i = 0; i < 3; i++) {
+		renderer.threads = threads[i];
+		RenderFrame(renderer, track, &gondola, &system);
+		sum[i] = Checksum(renderer.Pixels());
+	}
+	CHECK(sum[0] == sum[1] && sum[0] == sum[2]);
+	if (sum[0] != golden) printf("frame checksum: 0x%016llx\n", (unsigned long long)sum[0]);
+	CHECK(sum[0] == golden);
+	delete track;
+}
+
+//A kerékháló egyszer töltődik fel: a mozgó kerék képkockánként a GL-en át rajzolva sem tölt fel csúcsot
+//(glBufferData/glBufferSubData), a kerekek példányos rajzolása pedig csak a három példánypuffert
+static void TestWheelUploads() {
+	Spline* track = MakeTrack();
+	long before = GLUploads();
+	WheelMesh mesh;
+	CHECK(GLUploads() - before == 3); //test, körvonal, küllők
+	Gondola gondola(track, &mesh);
+	gondola.Start();
+	GondolaSystem system(track, &mesh);
+	AddWheels(system, track, 100);
+	GPUProgram program(nullptr, nullptr);
+	vec3 start = gondola.cposition;
+	long wheelUploads = 0, systemUploads = 0;
+	for (int frame = 0; frame < 100; frame++) {
+		gondola.Animate(1.0f / 60.0f);
+		system.Advance(1.0f / 60.0f);
+		long uploads = GLUploads();
+		gondola.Draw(&glBackend, &program);
+		wheelUploads += GLUploads() - uploads;
+		uploads = GLUploads();
+		system.Draw(&glBackend, &program);
+		systemUploads += GLUploads() - uploads;
+	}
+	CHECK(length(gondola.cposition - start) > 1.0f);
+	CHECK(wheelUploads == 0);
+	CHECK(systemUploads == 100 * 3);
+	delete track;
+}
+
+//Álló pályán a képkockák a CountingBackend szerint az elsőt követően egyetlen puffert sem foglalnak és töltenek fel:
+//a pálya, a kerékháló és a kerekek csúcsai a helyükön maradnak, csak a kerekek példányadatai (hely, szög) mennek fel
+static void TestSteadyStateUploads() {
+	CountingBackend counting;
+	backend = &counting;
+	Spline* track = MakeTrack();
+	WheelMesh mesh;
+	Gondola gondola(track, &mesh);
+	GondolaSystem system(track, &mesh);
+	backend = &glBackend;
+	gondola.Start();
+	AddWheels(system, track, 100);
+	size_t allocations = 0, uploads = 0, instanceUploads = 0, draws = 0;
+	for (int frame = 0; frame < 10; frame++) {
+		gondola.Animate(1.0f / 60.0f);
+		system.Advance(1.0f / 60.0f);
+		long calls = GLCalls();
+		gondola.Draw(&counting, nullptr);
+		system.Draw(&counting, nullptr);
+		track->Draw(&counting, nullptr);
+		CHECK(GLCalls() == calls);
+		if (frame > 0) {
+			CHECK(counting.allocations == allocations && counting.uploads == uploads);
+			CHECK(counting.instanceUploads - instanceUploads == 3); //test, körvonal, küllők
+			CHECK(counting.draws - draws == 3 + 3 + 2); //kerék, példányos kerekek, pálya és kontrollpontok
+		}
+		allocations = counting.allocations; uploads = counting.uploads;
+		instanceUploads = counting.instanceUploads; draws = counting.draws;
+	}
+	CHECK(uploads > 0);
+	delete track;
+}
+
+//Egy kerék a rendszerben lépésről lépésre bitre ugyanazt az utat járja be, mint a Gondola, mindkét integrátorral,
+//a lerepülésen és a repülésen át; a képkockák közti interpoláció is ugyanaz
+static void TestSystemMatchesGondola() {
+	Spline* track = MakeTrack();
+	Spline* hump = MakeHumpTrack();
+	WheelMesh mesh;
+	for (Integrator integrator : { RK4, SEMI_IMPLICIT_EULER }) for (Spline* path : { track, hump }) {
+		Gondola gondola(path, &mesh);
+		gondola.integrator = integrator;
+		gondola.Start();
+		GondolaSystem system(path, &mesh);
+		system.integrator = integrator;
+		system.Add(gondola.ivhossz);
+		int differ = 0, derailed = -1;
+		float dt[3] = { 1.0f / 60.0f, 1.0f / 144.0f, 1.0f / 30.0f };
+		for (int frame = 0; frame < 600; frame++) {
+			gondola.Animate(dt[frame % 3]);
+			system.Advance(dt[frame % 3]);
+			differ += gondola.State != system.state[0] || gondola.cposition.x != system.cposition[0].x ||
+				gondola.cposition.y != system.cposition[0].y || gondola.prevpos.x != system.prevpos[0].x ||
+				gondola.elfordulas != system.elfordulas[0] || gondola.alpha != system.alpha;
+			if (gondola.State == 1) differ += gondola.v != system.v[0] || gondola.ivhossz != system.ivhossz[0];
+			if (derailed < 0 && system.state[0] == 2) derailed = frame;
+		}
+		CHECK(differ == 0);
+		//a púpos pályán lerepül, az alkalmazás pályáján végig a pályán marad
+		CHECK(path == hump ? derailed > 0 : derailed < 0);
+	}
+
+	//a pálya legelejére tett kerék is elindul (a régi energiaképlettel v = 0 maradt)
+	GondolaSystem system(track, &mesh);
+	system.Add(0.0f);
+	system.Step(240, physicsStep);
+	CHECK(system.v[0] > 1.0f && system.ivhossz[0] > 1.0f);
+	delete track;
+	delete hump;
+}
+
+//Kerék-lépés másodpercenként, mindkét integrátorral: a képkocka lépései egy hívásban (egyszeri felosztás),
+//illetve lépésenként külön hívva. A képkockák száma a kerekek számával csökken, hogy a mérés rövid maradjon.
+static void BenchSystem() {
+	Spline* track = MakeTrack();
+	WheelMesh mesh;
+	printf("\nGondolaSystem, wheel steps per second (%u threads), frames of 4 steps\n", std::thread::hardware_concurrency());
+	printf("%8s %8s %20s %20s %20s\n", "wheels", "frames", "RK4 split per frame", "RK4 split per step", "Euler split per frame");
+	for (int n : { 1000, 100000, 1000000 }) {
+		int frames = std::max(2, 60000 / n * 4);
+		double rate[3];
+		for (int run = 0; run < 3; run++) {
+			GondolaSystem system(track, &mesh);
+			system.integrator = run == 2 ? SEMI_IMPLICIT_EULER : RK4;
+			AddWheels(system, track, n);
+			auto start = std::chrono::steady_clock::now();
+			for (int frame = 0; frame < frames; frame++) {
+				if (run == 1) for (int k = 0; k < 4; k++) system.Step(1, physicsStep);
+				else system.Step(4, physicsStep);
+			}
+			rate[run] = 4.0 * frames * n / Since(start);
+		}
+		printf("%8d %8d %20.3g %20.3g %20.3g\n", n, frames, rate[0], rate[1], rate[2]);
+		fflush(stdout);
+	}
+	delete track;
+}
+
+//Adaptív felbontás különböző méretű pályákon: csúcsok száma, a teljes felbontás ideje, valamint egy kontrollpont
+//hozzáadása és a vég újrabontása (100 hozzáadás átlaga)
+static void BenchTessellation() {
+	printf("\nAdaptive tessellation (0.5 pixel tolerance): vertices, full build and append time\n");
+	printf("%10s %12s %12s %12s %12s\n", "segments", "vertices", "per segment", "build [ms]", "append [us]");
+	for (int n : { 1, 10, 100, 1000, 10000, 100000 }) {
+		Spline* track = MakeRandomTrack(n + 1, 17);
+		auto start = std::chrono::steady_clock::now();
+		track->AddSpline();
+		double build = Since(start);
+		size_t vertices = track->SplinePoints.Vtx().size();
+		std::mt19937 rng(18);
+		std::uniform_real_distribution<float> u(-19.0f, 19.0f);
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 100; i++) {
+			track->AddControlPoint(vec3(u(rng), u(rng), 1.0f));
+			track->AddSpline();
+		}
+		double append = Since(start) / 100;
+		printf("%10d %12zu %12.1f %12.3f %12.2f\n", n, vertices, double(vertices) / n, build * 1e3, append * 1e6);
+		fflush(stdout);
+		delete track;
+	}
+}
+
+//Szakaszkeresés 10000 kontrollpontos pályán, ns hívásonként: a régi lineáris keresés, a FindSegment monoton
+//(a kerekek haladása, az előző szakasz a tipp) és véletlen sorrendű paraméterekre, valamint a teljes r(t)
+static void BenchFindSegment() {
+	Spline* track = MakeRandomTrack(10000, 14);
+	std::mt19937 rng(15);
+	std::uniform_real_distribution<float> u(track->ts.front(), track->ts.back());
+	const int calls = 1000000;
+	std::vector<float> random(calls), monotone(calls);
+	for (int i = 0; i < calls; i++) { random[i] = u(rng); monotone[i] = track->ts.back() * i / calls; }
+	long sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < calls / 1000; i++) sum += FindSegmentLinear(track, random[i]);
+	double linear = Since(start) / (calls / 1000);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < calls; i++) sum += track->FindSegment(monotone[i]);
+	double hinted = Since(start) / calls;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < calls; i++) sum += track->FindSegment(random[i]);
+	double searched = Since(start) / calls;
+	float x = 0.0f;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < calls; i++) x += track->r(random[i]).x;
+	double eval = Since(start) / calls;
+	CHECK(sum > 0 && x == x);
+	printf("\nSegment lookup on a 10000 control point track, ns per call\n");
+	printf("%12s %12s %12s %12s\n", "linear", "monotone", "random", "r(t) random");
+	printf("%12.1f %12.1f %12.1f %12.1f\n", linear * 1e9, hinted * 1e9, searched * 1e9, eval * 1e9);
+	fflush(stdout);
+	delete track;
+}
+
+//Ívhossz-táblázat sok szakaszos pályákon: a táblázat felépítése, valamint ParamAt és ArcLength hívásonként
+//(véletlen, nem monoton paraméterek, így a szakaszkeresés sem a tipp alapján történik)
+static void BenchArcLength() {
+	printf("\nArc-length table: build time, then ns per call with random parameters\n");
+	printf("%10s %12s %12s %12s\n", "segments", "build [ms]", "ParamAt", "ArcLength");
+	for (int n : { 10, 1000, 100000 }) {
+		Spline* track = MakeRandomTrack(n + 1, 10);
+		auto start = std::chrono::steady_clock::now();
+		float length = track->Length();
+		double build = Since(start);
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> us(0.0f, length), ut(track->ts.front(), track->ts.back());
+		const int calls = 1000000;
+		std::vector<float> s(calls), t(calls);
+		for (int i = 0; i < calls; i++) { s[i] = us(rng); t[i] = ut(rng); }
+		double sum = 0.0;
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < calls; i++) sum += track->ParamAt(s[i]);
+		double param = Since(start);
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < calls; i++) sum += track->ArcLength(t[i]);
+		double arc = Since(start);
+		CHECK(sum > 0.0);
+		printf("%10d %12.3f %12.1f %12.1f\n", n, build * 1e3, param / calls * 1e9, arc / calls * 1e9);
+		fflush(stdout);
+		delete track;
+	}
+}
+
+int main(int argc, char** argv) {
+	bool bench = argc > 1 && strcmp(argv[1], "bench") == 0;
+	TestSystemSteps();
+	TestIncrementalTessellation();
+	TestFindSegment();
+	TestBatchedEval();
+	TestArcLength();
+	TestSystemMatchesGondola();
+	TestCameraRoundTrip();
+	TestOffscreenCulling();
+	TestRenderFrameWithoutGL();
+	TestSteadyStateUploads();
+	TestWheelUploads();
+	if (bench) {
+		BenchSystem();
+		BenchTessellation();
+		BenchFindSegment();
+		BenchArcLength();
+	}
+	printf("gondola_test: %s\n", failures == 0 ? "OK" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,511 @@
+//=============================================================================================
+// terkep.cpp tesztjei és mérései GL nélkül (a csonk framework.h-val). "bench" argumentummal a mérések is futnak.
+//=============================================================================================
+#include "../terkep.cpp"
+#include <random>
+
+static int failures = 0;
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static double Since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+//n véletlen kattintás az ablakban, normalizált eszközkoordinátákban
+static std::vector<vec2> RandomClicks(int n, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> u(-0.95f, 0.95f);
+	std::vector<vec2> clicks(n);
+	for (vec2& c : clicks) c = vec2(u(rng), u(rng));
+	return clicks;
+}
+static bool SamePath(Path& a, Path& b) {
+	if (a.Vtx().size() != b.Vtx().size() || a.StripFirst() != b.StripFirst() || a.StripCount() != b.StripCount()) return false;
+	for (size_t i = 0; i < a.Vtx().size(); i++) if (a.Vtx()[i].x != b.Vtx()[i].x || a.Vtx()[i].y != b.Vtx()[i].y) return false;
+	return true;
+}
+
+//A Mercator x különbsége a dátumválasztón át (x és x +- 2 ugyanaz a pont)
+static double WrapDiff(double a, double b) {
+	double d = fabs(a - b);
+	return std::min(d, 2.0 - d);
+}
+//A kötegelt kernelek pontossága a skalár függvényekhez és egy double pontosságú referenciához képest,
+//|szélesség| <= 85 fokig, és az AVX2 ág egyezése a skalár maradékkal (n = 1-es hívás)
+static void TestKernelAccuracy() {
+	const int n = 100003; //nem 8 többszöröse, a maradék ág is fut
+	const double maxX = 4e-6, maxY = 1e-5, maxTail = 4e-6;
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	std::vector<float> lat(n), lon(n), x(n), y(n), z(n), t(n), mx(n), my(n);
+	for (int i = 0; i < n; i++) {
+		lat[i] = u(rng) * 85.0f;
+		lon[i] = u(rng) * 180.0f;
+		vec3 p = MapToSphere(vec2(lon[i] * float(M_PI / 180), lat[i] * float(M_PI / 180)));
+		x[i] = p.x; y[i] = p.y; z[i] = p.z;
+		t[i] = (i + 0.5f) / n;
+	}
+	double errRef[2] = { 0, 0 }, errScalar[2] = { 0, 0 }, errTail = 0;
+	auto Track = [&](double* err, double dx, double dy) { err[0] = std::max(err[0], dx); err[1] = std::max(err[1], dy); };
+
+	SphereToMercatorBatch(&x[0], &y[0], &z[0], n, &mx[0], &my[0]);
+	for (int i = 0; i < n; i++) {
+		vec2 s = MapToMercator(SphereToMap(vec3(x[i], y[i], z[i])));
+		double r = sqrt(double(x[i]) * x[i] + double(y[i]) * y[i] + double(z[i]) * z[i]);
+		Track(errRef, WrapDiff(mx[i], atan2(double(y[i]), double(x[i])) / M_PI), fabs(my[i] - atanh(z[i] / r) / M_PI));
+		Track(errScalar, WrapDiff(mx[i], s.x), fabs(my[i] - s.y));
+		float a, b;
+		SphereToMercatorBatch(&x[i], &y[i], &z[i], 1, &a, &b);
+		errTail = std::max(errTail, (double)std::max(fabs(a - mx[i]), fabs(b - my[i])));
+	}
+
+	MapToMercatorBatch(&lat[0], &lon[0], n, &mx[0], &my[0]);
+	for (int i = 0; i < n; i++) {
+		vec2 s = MapToMercator(vec2(lon[i] * float(M_PI / 180), lat[i] * float(M_PI / 180)));
+		Track(errRef, fabs(mx[i] - lon[i] / 180.0), fabs(my[i] - log(tan(M_PI / 4 + lat[i] * M_PI / 360)) / M_PI));
+		Track(errScalar, fabs(mx[i] - s.x), fabs(my[i] - s.y));
+		float a, b;
+		MapToMercatorBatch(&lat[i], &lon[i], 1, &a, &b);
+		errTail = std::max(errTail, (double)std::max(fabs(a - mx[i]), fabs(b - my[i])));
+	}
+
+	//Tokió - San Francisco, a dátumválasztón át
+	vec3 start = MapToSphere(vec2(139.7f * float(M_PI / 180), 35.7f * float(M_PI / 180)));
+	vec3 end = MapToSphere(vec2(-122.4f * float(M_PI / 180), 37.8f * float(M_PI / 180)));
+	float D = acos(dot(start, end));
+	GreatCircleBatch(start, end, D, &t[0], n, &mx[0], &my[0]);
+	for (int i = 0; i < n; i++) {
+		double a = sin((1.0 - t[i]) * D) / sin(D), b = sin(t[i] * D) / sin(D);
+		double px = a * start.x + b * end.x, py = a * start.y + b * end.y, pz = a * start.z + b * end.z;
+		double r = sqrt(px * px + py * py + pz * pz);
+		float fa = sin((1.0f - t[i]) * D) / sin(D), fb = sin(t[i] * D) / sin(D);
+		vec2 s = MapToMercator(SphereToMap(normalize(start * fa + end * fb)));
+		Track(errRef, WrapDiff(mx[i], atan2(py, px) / M_PI), fabs(my[i] - atanh(pz / r) / M_PI));
+		Track(errScalar, WrapDiff(mx[i], s.x), fabs(my[i] - s.y));
+		float ta, tb;
+		GreatCircleBatch(start, end, D, &t[i], 1, &ta, &tb);
+		errTail = std::max(errTail, (double)std::max(fabs(ta - mx[i]), fabs(tb - my[i])));
+	}
+	CHECK(errRef[0] <= maxX && errRef[1] <= maxY);
+	CHECK(errScalar[0] <= maxX && errScalar[1] <= maxY);
+	CHECK(errTail <= maxTail);
+	printf("kernel error vs double: %.2g, %.2g  vs scalar: %.2g, %.2g  simd vs tail: %.2g\n",
+		errRef[0], errRef[1], errScalar[0], errScalar[1], errTail);
+}
+
+//Földrajzi fokokból az állomások (Mercator / normalizált eszköz-) koordinátáiba
+static vec2 Geo(double latDeg, double lonDeg) {
+	return vec2(float(lonDeg / 180.0), float(atanh(sin(latDeg * M_PI / 180.0)) / M_PI));
+}
+//A from -> to főkör metszéspontja a dátumválasztóval (180 fok), Mercator y-ban, double pontossággal
+static double AntimeridianY(vec2 from, vec2 to) {
+	auto Sphere = [](vec2 m, double* p) {
+		double lon = m.x * M_PI, lat = 2.0 * atan(exp(m.y * M_PI)) - M_PI / 2.0;
+		p[0] = cos(lat) * cos(lon); p[1] = cos(lat) * sin(lon); p[2] = sin(lat);
+	};
+	double a[3], b[3];
+	Sphere(from, a); Sphere(to, b);
+	double n[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	//a főkör y = 0 síkkal vett metszete: n x (0, 1, 0), a negatív x felé eső fele
+	double px = -n[2], pz = n[0];
+	if (px > 0) { px = -px; pz = -pz; }
+	return atanh(pz / sqrt(px * px + pz * pz)) / M_PI;
+}
+//A sávok érvényesek: a pufferen belül, egymás után, egyik sem ugrik át a térképen, és minden csúcs a
+//[-1, 1] x [-latitudeLimit, latitudeLimit] tartományban van
+static bool ValidStrips(Path& path) {
+	const std::vector<vec2>& vtx = path.Vtx();
+	size_t next = 0;
+	for (size_t s = 0; s < path.StripFirst().size(); s++) {
+		size_t first = path.StripFirst()[s], count = path.StripCount()[s];
+		if (first != next || count < 2 || first + count > vtx.size()) return false;
+		for (size_t i = first; i < first + count; i++) {
+			if (fabs(vtx[i].x) > 1.0f || fabs(vtx[i].y) > 1.0f) return false;
+			if (i > first && fabs(vtx[i].x - vtx[i - 1].x) > 0.5f) return false;
+		}
+		next = first + count;
+	}
+	return next == vtx.size();
+}
+//Csendes-óceáni útvonalak: a dátumválasztón a sáv a főkör metszéspontjában ér véget x = +-1-en, és a következő
+//sáv ugyanabban a magasságban, a térkép másik szélén folytatódik; az egész egyetlen MultiDrawArrays hívás
+static void TestAntimeridianSplit() {
+	struct Route { const char* name; double lat0, lon0, lat1, lon1; };
+	const Route routes[] = {
+		{ "Tokyo - San Francisco", 35.7, 139.7, 37.8, -122.4 },
+		{ "San Francisco - Tokyo", 37.8, -122.4, 35.7, 139.7 },
+		{ "Sydney - Los Angeles", -33.9, 151.2, 34.1, -118.2 },
+		{ "Auckland - Santiago", -36.8, 174.8, -33.4, -70.7 },
+		{ "Anchorage - Vladivostok", 61.2, -149.9, 43.1, 131.9 },
+	};
+	const float tol = 2.0f / winWidth; //egy pixel: a töröttvonal fél pixeles tűrése és a float kerekítés
+	for (const Route& route : routes) {
+		Path path;
+		vec2 from = Geo(route.lat0, route.lon0), to = Geo(route.lat1, route.lon1);
+		path.addStation(from);
+		path.addStation(to);
+		path.MakePath();
+		CHECK(ValidStrips(path));
+		CHECK(path.StripFirst().size() == 2);
+		if (path.StripFirst().size() != 2) { printf("  %s\n", route.name); continue; }
+		const std::vector<vec2>& vtx = path.Vtx();
+		vec2 a = vtx[path.StripCount()[0] - 1], b = vtx[path.StripFirst()[1]];
+		float edge = from.x > 0.0f ? 1.0f : -1.0f; //nyugatról keletre haladva +1-en lép ki
+		double y = AntimeridianY(from, to);
+		CHECK(a.x == edge && b.x == -edge);
+		CHECK(a.y == b.y);
+		CHECK(fabs(a.y - y) < tol);
+		CHECK(length(vtx.front() - from) < 1e-5f && length(vtx.back() - to) < 1e-5f);
+	}
+	//Pontosan a dátumválasztón álló állomás (+-180 fok): a térkép egyik szélén ér véget az egyik sáv, a másikon
+	//kezdődik a következő, átugró szakasz nélkül
+	for (double lon : { 180.0, -180.0 }) for (int dir = 0; dir < 2; dir++) {
+		Path path;
+		vec2 ends[2] = { Geo(10.0, 20.0), Geo(-30.0, -60.0) };
+		path.addStation(ends[dir]);
+		path.addStation(Geo(0.0, lon));
+		path.addStation(ends[1 - dir]);
+		path.MakePath();
+		CHECK(ValidStrips(path));
+		CHECK(path.StripFirst().size() == 2);
+	}
+	//Két szakasz a dátumválasztón oda és vissza: három sáv, egy hívással
+	Path path;
+	path.addStation(Geo(35.7, 139.7));
+	path.addStation(Geo(37.8, -122.4));
+	path.addStation(Geo(-33.9, 151.2));
+	path.MakePath();
+	CHECK(ValidStrips(path));
+	CHECK(path.StripFirst().size() == 3);
+	GPUProgram program(nullptr, nullptr);
+	long calls = GLCalls();
+	path.drawPath(&program);
+	CHECK(GLCalls() - calls == 4); //vonalvastagság, Bind (2), MultiDrawArrays
+}
+//A sarkon át vezető szakasz a szélességi korlátnál (Mercator y = +-1) megszakad, és a túloldalon újrakezdődik
+static void TestLatitudeClip() {
+	Path path;
+	path.addStation(Geo(80.0, 0.0));
+	path.addStation(Geo(80.0, 170.0));
+	path.MakePath();
+	CHECK(ValidStrips(path));
+	CHECK(path.StripFirst().size() == 2);
+	if (path.StripFirst().size() != 2) return;
+	const std::vector<vec2>& vtx = path.Vtx();
+	CHECK(vtx[path.StripCount()[0] - 1].y == 1.0f);
+	CHECK(vtx[path.StripFirst()[1]].y == 1.0f);
+}
+
+//Egy két állomásos útvonal: a csúcsok mind végesek-e (a ValidStrips NaN-nál nem jelezne), és hány csúcs lett
+static size_t LegVertices(vec2 from, vec2 to, bool* finite) {
+	Path path;
+	path.addStation(from);
+	path.addStation(to);
+	path.MakePath();
+	*finite = ValidStrips(path);
+	for (const vec2& v : path.Vtx()) *finite = *finite && std::isfinite(v.x) && std::isfinite(v.y);
+	return path.Vtx().size();
+}
+//Az AppendArc elfajuló ágai: egybeeső állomások (D < 1e-6) és (közel) átellenes állomások (pi - D < 1e-3), ahol
+//a főkör a pólus felé kerül; NaN nélkül, értelmes csúcsszámmal. Rövid szakaszhoz kevesebb csúcs kell, mint hosszúhoz.
+static void TestDegenerateArcs() {
+	bool finite;
+	vec2 a = Geo(10.0, 20.0);
+	size_t same = LegVertices(a, a, &finite);
+	CHECK(finite && same == 2);
+	for (double dlat : { 0.0, 0.01, -0.02 }) {
+		size_t anti = LegVertices(a, Geo(-10.0 + dlat, -160.0 + dlat), &finite);
+		CHECK(finite && anti >= 16 && anti <= 1000);
+	}
+	size_t prev = 0, first = 0;
+	for (double d : { 0.1, 1.0, 10.0, 60.0 }) {
+		size_t leg = LegVertices(Geo(20.0, 0.0), Geo(20.0 + d, d), &finite);
+		CHECK(finite && leg >= prev);
+		if (prev == 0) first = leg;
+		prev = leg;
+	}
+	CHECK(first < prev);
+}
+
+//Kattintásonként építve ugyanaz az útvonal, mint egyszerre; egy kattintás és egy újrarajzolás GL hívásainak száma
+//nem függ az állomások számától, a változatlan útvonal rajzolása nem tölt fel semmit
+static void TestIncrementalPath() {
+	std::vector<vec2> clicks = RandomClicks(500, 1);
+	Path incremental, batch;
+	long clickCalls = 0, drawCalls = 0;
+	GPUProgram program(nullptr, nullptr);
+	for (size_t i = 0; i < clicks.size(); i++) {
+		long calls = GLCalls();
+		incremental.addStation(clicks[i]);
+		incremental.MakePath();
+		clickCalls = std::max(clickCalls, GLCalls() - calls);
+		calls = GLCalls();
+		incremental.drawPath(&program);
+		drawCalls = std::max(drawCalls, GLCalls() - calls);
+	}
+	batch.addStations(&clicks[0], clicks.size());
+	batch.MakePath();
+	CHECK(SamePath(incremental, batch));
+	CHECK(clickCalls <= 4); //Bind (2), esetleg puffernövelés, részleges feltöltés
+	CHECK(drawCalls <= 4);	//vonalvastagság, Bind (2), egy MultiDrawArrays
+}
+
+//Egy kattintás (állomás és szakasz hozzáadása) átlagos ideje a 10000 állomásos útvonal építése közben:
+//lapos marad, mert csak az új szakasz készül el és megy fel
+static void BenchClicks() {
+	const int n = 10000, window = 200;
+	std::vector<vec2> clicks = RandomClicks(n, 2);
+	Station station;
+	Path path;
+	printf("\nclick cost while building a %d-station route\n%10s %16s %12s\n", n, "stations", "us/click", "vertices");
+	for (int i = 0; i < n; ) {
+		auto start = std::chrono::steady_clock::now();
+		for (int k = 0; k < window; k++, i++) {
+			station.addStation(clicks[i]);
+			path.addStation(clicks[i]);
+			path.MakePath();
+		}
+		if (i == window || i % 2000 == 0) printf("%10d %16.2f %12zu\n", i, Since(start) * 1e6 / window, path.Vtx().size());
+	}
+	fflush(stdout);
+}
+
+static std::vector<char> ReadFile(const char* filename) {
+	std::vector<char> data;
+	FILE* file = fopen(filename, "rb");
+	if (!file) return data;
+	char buffer[4096];
+	for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0; ) data.insert(data.end(), buffer, buffer + n);
+	fclose(file);
+	return data;
+}
+static void WriteFile(const char* filename, const std::vector<char>& data) {
+	FILE* file = fopen(filename, "wb");
+	if (!file) return;
+	if (!data.empty()) fwrite(&data[0], 1, data.size(), file);
+	fclose(file);
+}
+//Az előre felbontott útvonal oda-vissza ugyanaz, és folytatható; a hibás indexű, nem véges vagy csonka fájlt
+//a betöltés elutasítja, és a már meglévő útvonal változatlan marad
+static void TestTessellatedFile() {
+	const char* filename = "terkep_test_path.bin";
+	std::vector<vec2> clicks = RandomClicks(50, 5);
+	Path saved;
+	saved.addStations(&clicks[0], 40);
+	saved.MakePath();
+	CHECK(saved.SaveTessellated(filename));
+	Path loaded;
+	CHECK(loaded.LoadTessellated(filename));
+	CHECK(SamePath(saved, loaded) && loaded.stations.size() == 40);
+	saved.addStations(&clicks[40], 10);
+	saved.MakePath();
+	loaded.addStations(&clicks[40], 10);
+	loaded.MakePath();
+	CHECK(SamePath(saved, loaded));
+
+	loaded.SaveTessellated(filename);
+	const std::vector<char> good = ReadFile(filename);
+	PathFileHeader header;
+	memcpy(&header, &good[0], sizeof(header));
+	size_t stripsAt = sizeof(header) + (size_t(header.stations) + header.vertices) * sizeof(vec2);
+	auto Rejected = [&](std::vector<char> data) {
+		WriteFile(filename, data);
+		Path path;
+		path.addStations(&clicks[0], 3);
+		path.MakePath();
+		Path before;
+		before.addStations(&clicks[0], 3);
+		before.MakePath();
+		bool rejected = !path.LoadTessellated(filename);
+		return rejected && SamePath(path, before) && path.stations.size() == 3;
+	};
+	auto WithHeader = [&](void (*change)(PathFileHeader&)) {
+		std::vector<char> data = good;
+		PathFileHeader h;
+		memcpy(&h, &data[0], sizeof(h));
+		change(h);
+		memcpy(&data[0], &h, sizeof(h));
+		return data;
+	};
+	auto WithInt = [&](size_t offset, int value) {
+		std::vector<char> data = good;
+		memcpy(&data[offset], &value, sizeof(value));
+		return data;
+	};
+	CHECK(!Rejected(good));
+	CHECK(Rejected(std::vector<char>(good.begin(), good.end() - 1)));
+	std::vector<char> longer = good;
+	longer.push_back(0);
+	CHECK(Rejected(longer));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.magic[3] = '2'; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.legs = h.stations; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.closeVertices = h.vertices + 1; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.closeStrips = h.strips + 1; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.closeLastCount = -1; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.closeLastCount = h.closeVertices + 1; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.lastX = NAN; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.vertices++; })));
+	CHECK(Rejected(WithHeader([](PathFileHeader& h) { h.strips = 0x80000000u; })));
+	size_t countsAt = stripsAt + header.strips * sizeof(int);
+	CHECK(Rejected(WithInt(stripsAt, -1)));
+	CHECK(Rejected(WithInt(stripsAt + (header.strips - 1) * sizeof(int), (int)header.vertices)));
+	CHECK(Rejected(WithInt(countsAt, -2)));
+	CHECK(Rejected(WithInt(countsAt + (header.strips - 1) * sizeof(int), (int)header.vertices + 1)));
+	CHECK(Rejected(WithInt(countsAt, 0x7fffffff)));
+	std::vector<char> nan = good;
+	float bad = NAN;
+	memcpy(&nan[sizeof(header) + header.stations * sizeof(vec2) + 4], &bad, sizeof(bad));
+	CHECK(Rejected(nan));
+	remove(filename);
+}
+//Tömeges importálás szövegből és binárisból: a tartományon kívüli és a nem véges koordinátájú pontok kimaradnak és
+//meg vannak számolva; a nem számmal kezdődő sorok (fejléc, megjegyzés) nem pontok, ezek nem számítanak bele
+static void TestImportRange() {
+	const char* csv = "terkep_test_route.txt";
+	FILE* file = fopen(csv, "w");
+	fprintf(file, "# lat,lon\n47.5,19.0\n91,0\n-90,-180\n0;181\n-45.5 170\nnan,10\n10,-inf\nabc\n90.0001,0\n");
+	fclose(file);
+	Station station;
+	Path path;
+	RouteImporter text(&station, &path);
+	CHECK(text.Load(csv) == 3);
+	CHECK(text.Skipped() == 4); //91; 181; -inf; 90.0001 ("nan" és "abc" nem pont)
+	CHECK(station.Vtx().size() == 3 && path.stations.size() == 3);
+	for (const vec2& p : path.stations) CHECK(std::isfinite(p.x) && std::isfinite(p.y) && fabs(p.x) <= 1.0f);
+
+	const char* bin = "terkep_test_route.bin";
+	const float points[6][2] = { { 10, 20 }, { -91, 0 }, { 0, 180 }, { 0, -180.5f }, { NAN, 0 }, { -30, -60 } };
+	uint32_t count = 6;
+	file = fopen(bin, "wb");
+	fwrite("WPT1", 1, 4, file);
+	fwrite(&count, sizeof(count), 1, file);
+	fwrite(points, sizeof(points), 1, file);
+	fclose(file);
+	RouteImporter binary(&station, &path);
+	CHECK(binary.Load(bin) == 3);
+	CHECK(binary.Skipped() == 3);
+	CHECK(path.stations.size() == 6);
+	CHECK(ValidStrips(path));
+	remove(csv);
+	remove(bin);
+}
+
+//Pont/s a skalár függvényláncokkal és a kötegelt kernelekkel, 1M pontra
+static void BenchKernels() {
+	const int n = 1 << 20, reps = 8;
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+	std::vector<float> lat(n), lon(n), x(n), y(n), z(n), t(n), mx(n), my(n);
+	for (int i = 0; i < n; i++) {
+		lat[i] = u(rng) * 85.0f;
+		lon[i] = u(rng) * 180.0f;
+		vec3 p = MapToSphere(vec2(lon[i] * float(M_PI / 180), lat[i] * float(M_PI / 180)));
+		x[i] = p.x; y[i] = p.y; z[i] = p.z;
+		t[i] = (i + 0.5f) / n;
+	}
+	vec3 start = MapToSphere(vec2(139.7f * float(M_PI / 180), 35.7f * float(M_PI / 180)));
+	vec3 end = MapToSphere(vec2(-122.4f * float(M_PI / 180), 37.8f * float(M_PI / 180)));
+	float D = acos(dot(start, end));
+	double checksum = 0, rate[3][2];
+	for (int kernel = 0; kernel < 3; kernel++) for (int batch = 0; batch < 2; batch++) {
+		auto begin = std::chrono::steady_clock::now();
+		for (int r = 0; r < reps; r++) {
+			if (batch) {
+				if (kernel == 0) GreatCircleBatch(start, end, D, &t[0], n, &mx[0], &my[0]);
+				if (kernel == 1) SphereToMercatorBatch(&x[0], &y[0], &z[0], n, &mx[0], &my[0]);
+				if (kernel == 2) MapToMercatorBatch(&lat[0], &lon[0], n, &mx[0], &my[0]);
+			}
+			else for (int i = 0; i < n; i++) {
+				vec2 m;
+				if (kernel == 0) {
+					float a = sin((1.0f - t[i]) * D) / sin(D), b = sin(t[i] * D) / sin(D);
+					m = MapToMercator(SphereToMap(normalize(start * a + end * b)));
+				}
+				if (kernel == 1) m = MapToMercator(SphereToMap(vec3(x[i], y[i], z[i])));
+				if (kernel == 2) m = MapToMercator(vec2(lon[i] * float(M_PI / 180), lat[i] * float(M_PI / 180)));
+				mx[i] = m.x; my[i] = m.y;
+			}
+			checksum += mx[n / 2] + my[n / 3];
+		}
+		rate[kernel][batch] = double(n) * reps / Since(begin);
+	}
+	const char* names[3] = { "slerp->mercator", "sphere->mercator", "latlon->mercator" };
+	printf("\nprojection kernels, %d points (checksum %g)\n%18s %16s %16s %8s\n", n, checksum, "chain", "scalar pts/s", "batch pts/s", "speedup");
+	for (int k = 0; k < 3; k++) printf("%18s %16.3g %16.3g %8.1f\n", names[k], rate[k][0], rate[k][1], rate[k][1] / rate[k][0]);
+	fflush(stdout);
+}
+
+//Tömeges betöltés ideje: n útvonalpont szövegből és binárisból (importálás, Mercator, útvonal-építés, egy feltöltés),
+//majd az elkészült útvonal előre felbontott fájlból. A pontok véletlen bolyongás, fél foknál kisebb lépésekkel.
+static void BenchImport() {
+	const char* csv = "terkep_bench_route.txt";
+	const char* bin = "terkep_bench_route.bin";
+	const char* tessellated = "terkep_bench_path.bin";
+	printf("\nroute import and tessellated load\n%10s %12s %12s %12s %12s %12s\n", "waypoints", "csv ms", "binary ms", "vertices", "save ms", "load ms");
+	for (int n : { 10000, 100000, 1000000 }) {
+		std::mt19937 rng(6);
+		std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+		std::vector<float> points(2 * n);
+		float lat = 0.0f, lon = 0.0f;
+		FILE* text = fopen(csv, "w");
+		for (int i = 0; i < n; i++) {
+			lat = std::max(-80.0f, std::min(lat + step(rng), 80.0f));
+			lon += step(rng);
+			if (lon > 180.0f) lon -= 360.0f;
+			if (lon < -180.0f) lon += 360.0f;
+			points[2 * i] = lat; points[2 * i + 1] = lon;
+			fprintf(text, "%.5f,%.5f\n", lat, lon);
+		}
+		fclose(text);
+		FILE* binary = fopen(bin, "wb");
+		uint32_t count = n;
+		fwrite("WPT1", 1, 4, binary);
+		fwrite(&count, sizeof(count), 1, binary);
+		fwrite(&points[0], sizeof(float), points.size(), binary);
+		fclose(binary);
+
+		double ms[4];
+		size_t vertices = 0;
+		for (int format = 0; format < 2; format++) {
+			Station station;
+			Path path;
+			auto start = std::chrono::steady_clock::now();
+			size_t loaded = RouteImporter(&station, &path).Load(format == 0 ? csv : bin);
+			ms[format] = Since(start) * 1e3;
+			CHECK(loaded == (size_t)n);
+			vertices = path.Vtx().size();
+			if (format == 1) {
+				start = std::chrono::steady_clock::now();
+				CHECK(path.SaveTessellated(tessellated));
+				ms[2] = Since(start) * 1e3;
+			}
+		}
+		Path loaded;
+		auto start = std::chrono::steady_clock::now();
+		CHECK(loaded.LoadTessellated(tessellated));
+		ms[3] = Since(start) * 1e3;
+		CHECK(loaded.Vtx().size() == vertices);
+		printf("%10d %12.1f %12.1f %12zu %12.1f %12.1f\n", n, ms[0], ms[1], vertices, ms[2], ms[3]);
+		fflush(stdout);
+	}
+	remove(csv);
+	remove(bin);
+	remove(tessellated);
+}
+
+int main(int argc, char** argv) {
+	bool bench = argc > 1 && strcmp(argv[1], "bench") == 0;
+	TestKernelAccuracy();
+	TestIncrementalPath();
+	TestAntimeridianSplit();
+	TestLatitudeClip();
+	TestDegenerateArcs();
+	TestTessellatedFile();
+	TestImportRange();
+	if (bench) {
+		BenchKernels();
+		BenchClicks();
+		BenchImport();
+	}
+	printf("terkep_test: %s\n", failures == 0 ? "OK" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}